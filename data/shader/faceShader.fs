@@ -0,0 +1,54 @@
+#version 130
+
+varying vec3 cubePos0;
+varying vec3 localNormal0;
+varying vec3 normal0;
+
+// One layer per face, each texel the color of one facelet, in the order
+// -x, +x, -y, +y, -z, +z.
+uniform sampler2DArray facelets;
+uniform vec3 palette[7];
+
+// Positions on the cube of the highlighted blocks, or -1 for none.
+uniform vec3 selected;
+uniform vec3 hovered;
+
+void main() {
+  float size = float(textureSize(facelets, 0).x);
+
+  vec3 a = abs(localNormal0);
+  int axis = 2;
+  if (a.x >= a.y && a.x >= a.z) {
+    axis = 0;
+  } else if (a.y >= a.z) {
+    axis = 1;
+  }
+  int face = axis * 2 + (localNormal0[axis] > 0.0 ? 1 : 0);
+
+  // Facelet coordinates are block positions along the remaining axes, in
+  // X, Y, Z order.
+  int uAxis = (axis == 0) ? 1 : 0;
+  int vAxis = (axis == 2) ? 1 : 2;
+  vec2 uv = (vec2(cubePos0[uAxis], cubePos0[vAxis]) + size) * 0.5;
+
+  // Faces cut through the cube, between a turning slab and the rest, are
+  // bare plastic.
+  vec3 color = palette[0];
+  if (abs(cubePos0[axis]) > size - 0.001) {
+    float index = texture(facelets, vec3(uv.y / size, uv.x / size,
+                                         float(face))).r * 255.0;
+    vec2 offset = abs(fract(uv) - 0.5) * 2.0;
+    float sticker = 1.0 - smoothstep(0.78, 0.82, max(offset.x, offset.y));
+    color = mix(palette[0], palette[int(index + 0.5) + 1], sticker);
+  }
+
+  vec3 cell = floor((cubePos0 - localNormal0 * 0.5 + size) * 0.5);
+  if (cell == selected) {
+    color = mix(color, vec3(1.0), 0.5);
+  } else if (cell == hovered) {
+    color = mix(color, vec3(1.0), 0.25);
+  }
+
+  gl_FragColor = vec4(color, 1.0)
+    * clamp(dot(-vec3(0,0,1), normal0), 0.0, 1.0);
+}
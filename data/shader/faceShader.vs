@@ -0,0 +1,26 @@
+#version 130
+
+attribute vec3 position;
+attribute vec2 texCoord;
+attribute vec3 normal;
+
+varying vec3 cubePos0;
+varying vec3 localNormal0;
+varying vec3 normal0;
+
+uniform mat4 transform;
+
+// Part of the cube drawn, in the cube's own coordinates, which run from
+// -size to size along each axis. The mesh is a box from -1 to 1.
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+
+void main() {
+  vec3 cubePos = mix(boxMin, boxMax, position * 0.5 + 0.5);
+
+  // Lambertian Lighting
+  gl_Position = transform * vec4(cubePos, 1.0);
+  normal0 = (transform * vec4(normal, 0.0)).xyz;
+  cubePos0 = cubePos;
+  localNormal0 = normal;
+}
@@ -0,0 +1,13 @@
+#version 130
+
+varying vec2 texCoord0;
+varying vec3 normal0;
+varying float layer0;
+
+uniform sampler2DArray diffuse;
+
+void main() {
+  vec3 flipped_texcoord = vec3(texCoord0.x, 1.0 - texCoord0.y, layer0);
+  gl_FragColor = texture(diffuse, flipped_texcoord)
+    * clamp(dot(-vec3(0,0,1), normal0), 0.0, 1.0);
+}
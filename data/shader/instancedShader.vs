@@ -0,0 +1,39 @@
+#version 130
+
+attribute vec3 position;
+attribute vec2 texCoord;
+attribute vec3 normal;
+
+// Per-instance attributes.
+attribute float orientation;
+attribute float posX;
+attribute float posY;
+attribute float posZ;
+attribute float texIndex;
+attribute float scale;
+
+varying vec2 texCoord0;
+varying vec3 normal0;
+varying float layer0;
+
+uniform mat4 viewProjection;
+
+// Rotation of each orientation a block can rest in.
+uniform mat4 orientations[24];
+
+#include "slab.glsl"
+
+void main() {
+  // Position and orientation arrive from separate arrays.
+  mat4 model = orientations[int(orientation)];
+  model[3] = vec4(posX, posY, posZ, 1.0);
+
+  mat4 world = TurnSlabs(model);
+
+  // Lambertian Lighting
+  mat4 transform = viewProjection * world;
+  gl_Position = transform * vec4(position * scale, 1.0);
+  texCoord0 = texCoord;
+  normal0 = (transform * vec4(normal, 0.0)).xyz;
+  layer0 = texIndex;
+}
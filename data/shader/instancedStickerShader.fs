@@ -0,0 +1,19 @@
+#version 130
+
+varying vec3 normal0;
+varying vec3 localPos0;
+varying vec3 localNormal0;
+
+// Palette index of the sticker on each face of the block, in the order
+// -x, +x, -y, +y, -z, +z. Index 0 is the plastic between stickers.
+varying vec3 faceColors00;
+varying vec3 faceColors10;
+
+#include "sticker.glsl"
+
+void main() {
+  vec3 color = StickerColor(localPos0, localNormal0, faceColors00,
+                            faceColors10);
+  gl_FragColor = vec4(color, 1.0)
+    * clamp(dot(-vec3(0,0,1), normal0), 0.0, 1.0);
+}
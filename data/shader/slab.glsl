@@ -0,0 +1,34 @@
+// Slab rotations in progress, up to MAX_SLICES (defined by Shader) at once.
+// Instances centered within half a block of slicePos[i] along sliceAxis are
+// turned by sliceAngle[i] about sliceAxis. Unused entries have no angle.
+uniform vec3 sliceAxis;
+uniform float slicePos[MAX_SLICES];
+uniform float sliceAngle[MAX_SLICES];
+
+// Rotation of angle radians about a unit axis (Rodrigues' formula).
+mat3 AxisRotation(vec3 axis, float angle) {
+  float c = cos(angle);
+  float s = sin(angle);
+  float t = 1.0 - c;
+  return mat3(t * axis.x * axis.x + c,
+              t * axis.x * axis.y + s * axis.z,
+              t * axis.x * axis.z - s * axis.y,
+              t * axis.x * axis.y - s * axis.z,
+              t * axis.y * axis.y + c,
+              t * axis.y * axis.z + s * axis.x,
+              t * axis.x * axis.z + s * axis.y,
+              t * axis.y * axis.z - s * axis.x,
+              t * axis.z * axis.z + c);
+}
+
+// Transform of an instance to the world, turning it with the slab it is in.
+mat4 TurnSlabs(mat4 model) {
+  mat4 world = model;
+  float along = dot(model[3].xyz, sliceAxis);
+  for (int i = 0; i < MAX_SLICES; i++) {
+    if (sliceAngle[i] != 0.0 && abs(along - slicePos[i]) < 0.5) {
+      world = mat4(AxisRotation(sliceAxis, sliceAngle[i])) * model;
+    }
+  }
+  return world;
+}
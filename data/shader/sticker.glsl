@@ -0,0 +1,26 @@
+// Color of each palette index.
+uniform vec3 palette[7];
+
+// Color of a point on a block from the face it lies on and its position on
+// that face, both in the block's own frame.
+vec3 StickerColor(vec3 pos, vec3 normal, vec3 colors0, vec3 colors1) {
+  vec3 a = abs(normal);
+  int axis = 2;
+  vec2 uv = pos.xy;
+  if (a.x >= a.y && a.x >= a.z) {
+    axis = 0;
+    uv = pos.yz;
+  } else if (a.y >= a.z) {
+    axis = 1;
+    uv = pos.xz;
+  }
+  int face = axis * 2 + (normal[axis] > 0.0 ? 1 : 0);
+  float color = (face < 3) ? colors0[face] : colors1[face - 3];
+
+  // Stickers cover the flat of each face, leaving a plastic border, and
+  // none lie on the bevels between faces.
+  float edge = max(abs(uv.x), abs(uv.y));
+  float sticker = (1.0 - smoothstep(0.78, 0.82, edge)) *
+                  step(0.99, a[axis]);
+  return mix(palette[0], palette[int(color + 0.5)], sticker);
+}
@@ -0,0 +1,19 @@
+#version 130
+
+varying vec3 normal0;
+varying vec3 localPos0;
+varying vec3 localNormal0;
+
+// Palette index of the sticker on each face of the block, in the order
+// -x, +x, -y, +y, -z, +z. Index 0 is the plastic between stickers.
+uniform vec3 faceColors0;
+uniform vec3 faceColors1;
+
+#include "sticker.glsl"
+
+void main() {
+  vec3 color = StickerColor(localPos0, localNormal0, faceColors0,
+                            faceColors1);
+  gl_FragColor = vec4(color, 1.0)
+    * clamp(dot(-vec3(0,0,1), normal0), 0.0, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 130
+
+attribute vec3 position;
+attribute vec2 texCoord;
+attribute vec3 normal;
+
+varying vec3 normal0;
+varying vec3 localPos0;
+varying vec3 localNormal0;
+
+uniform mat4 transform;
+
+void main() {
+  // Lambertian Lighting
+  gl_Position = transform * vec4(position, 1.0);
+  normal0 = (transform * vec4(normal, 0.0)).xyz;
+  localPos0 = position;
+  localNormal0 = normal;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file batch_solver.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a batch solver, which reads 3x3
+ * cubes from a stream, solves them on a pool of threads and writes the
+ * solutions in the order the cubes were read.
+ */
+
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "./cubie_cube.h"
+#include "./optimal_solver.h"
+#include "./two_phase.h"
+
+class BatchSolver {
+  public:
+    /**
+     * Constructor for a batch solver using the two-phase solver.
+     *
+     * @param solver The solver.
+     * @param numThreads Number of threads to solve with, or 0 for one per
+     *    core.
+     * @param bufferSize Most cubes read but not yet written at once.
+     */
+    explicit BatchSolver(const TwoPhaseSolver& solver, int numThreads = 0,
+                         size_t bufferSize = 1024);
+
+    /**
+     * Constructor for a batch solver using the optimal solver. Each cube is
+     *    solved on a single thread, so the solver should have been made with
+     *    one thread.
+     *
+     * @param solver The solver, with its pattern databases loaded.
+     * @param numThreads Number of threads to solve with, or 0 for one per
+     *    core.
+     * @param bufferSize Most cubes read but not yet written at once.
+     */
+    explicit BatchSolver(const OptimalSolver& solver, int numThreads = 0,
+                         size_t bufferSize = 1024);
+
+    /**
+     * Solve every cube in a stream, one per line. A line holds either a
+     * sequence of face turns scrambling a solved cube (such as "R U2 F'"),
+     * or the 54 facelets of a cube written as by CubeState::ToString()
+     * without line breaks. Blank lines and lines starting with '#' are
+     * skipped.
+     *
+     * For each cube one line is written: its solution, or "ERROR" and the
+     * reason it could not be solved.
+     *
+     * @param input The cubes.
+     * @param output The solutions.
+     * @param report Stream to print throughput and latency to at the end.
+     * @return True if every cube was solved, otherwise false.
+     */
+    bool Run(std::istream& input, std::ostream& output,
+             std::ostream& report);
+
+    /**
+     * Read a cube from a line of text.
+     *
+     * @param line The line.
+     * @param cube The cube (to be set).
+     * @param error Why the line is not a cube (to be set on failure).
+     * @return True if the line is a cube, otherwise false.
+     */
+    static bool ParseCube(const std::string& line, CubieCube& cube,
+                          std::string& error);
+
+    /**
+     * Write face turns as text, such as "R U2 F'".
+     *
+     * @param turns The face turns.
+     * @return The text.
+     */
+    static std::string FormatTurns(const std::vector<FaceTurn>& turns);
+  protected:
+  private:
+    /**
+     * A cube waiting to be solved.
+     */
+    struct Job {
+      uint64_t sequence;  // Position of the cube in the input.
+      CubieCube cube;
+      std::string error;  // Why the line could not be read, if it could not.
+    };
+
+    /**
+     * A slot of the reorder buffer, holding a solved cube until every cube
+     * before it has been written.
+     */
+    struct Result {
+      bool ready;
+      bool solved;
+      std::string text;
+      double seconds;  // Time taken to solve.
+    };
+
+    /**
+     * Solve jobs until the input is exhausted.
+     */
+    void SolveJobs();
+
+    /**
+     * Write results in input order until every cube read has been written.
+     *
+     * @param output The solutions.
+     */
+    void WriteResults(std::ostream* output);
+
+    const TwoPhaseSolver* m_twoPhase;
+    const OptimalSolver* m_optimal;
+    int m_numThreads;
+    size_t m_bufferSize;
+
+    std::mutex m_mutex;
+    std::condition_variable m_jobAdded;     // A job or the end of input.
+    std::condition_variable m_resultReady;  // The next result to write.
+    std::condition_variable m_slotFreed;    // Room in the reorder buffer.
+    std::deque<Job> m_jobs;
+    std::vector<Result> m_results;          // Indexed by sequence % size.
+    uint64_t m_numRead;
+    uint64_t m_numWritten;
+    bool m_inputDone;
+
+    // Filled in by the writer, in input order.
+    std::vector<double> m_latencies;
+    uint64_t m_numFailed;
+};
+
+#endif  // BATCH_SOLVER_H
@@ -10,42 +10,79 @@
 #ifndef CUBE_H
 #define CUBE_H
 
+#include <deque>
+#include <utility>
 #include <vector>
 #include "./block.h"
+#include "./cube_state.h"
+#include "./face_texture.h"
+#include "./slice_table.h"
 #include "./texture.h"
 #include "./shader.h"
 #include "./transform.h"
 #include "./camera.h"
 #include "./mesh.h"
-
-/**
- * @enum Dimensions of rotation and translation.
- */
-enum Dim {
-  X = 0,
-  Y = 1,
-  Z = 2
-};
+#include "./orientation.h"
 
 class Cube {
   public:
+    // Rate at which UpdateRotation advances the simulation.
+    static const int TICKS_PER_SECOND = 120;
+    // Most rotations waiting to start; further ones are dropped.
+    static const size_t MAX_QUEUED_MOVES = 1024;
+    // Most slabs turning at once, all passed to the shader together.
+    static const size_t MAX_PARALLEL_TURNS = Shader::MAX_SLICES;
+
+    /**
+     * @enum Ways of playing queued rotations.
+     */
+    enum Playback {
+      ANIMATED,  // Each rotation lasts as long as SetMovesPerSecond sets.
+      TURBO,     // Rotations shorten the more are queued behind them.
+      INSTANT    // Rotations land as soon as they start, unanimated.
+    };
+
     /**
      * Constructor for a cube.
      *
      * @param size Size of each dimension of the cube, i.e. the cube will be
      *    made up of a size*size*size collection of blocks.
+     * @param instanced True to draw every block of the cube with a single
+     *    instanced draw call, false to issue one draw call per block.
+     * @param procedural True to color stickers in the shader from each
+     *    block's face colors and a palette, loading no textures, false to
+     *    sample a texture for each color combination.
+     * @param faceTextures True to keep no blocks and draw each face as one
+     *    quad sampling a texture of its stickers, so that drawing costs
+     *    nearly the same at any size. Overrides instanced and procedural.
      */
-    Cube(int size);
+    Cube(int size, bool instanced = false, bool procedural = false,
+         bool faceTextures = false);
 
     /**
-     * Start a new rotation on a cube. Does nothing if the cube is already
-     * rotating.
+     * Queue a new rotation on a cube. It starts at once if the cube is idle,
+     * otherwise on the tick the rotations ahead of it complete.
      *
      * @param axis Axis about which to rotate.
      * @param n Slab of blocks between 0 and size to be rotated.
      * @param clockwise Rotate clockwise if true, counterclockwise if false.
+     * @return True if queued, false if the slab is out of range or the queue
+     *    is full, in which case the rotation is dropped and counted.
      */
-    void SetRotation(Dim axis, int n, bool clockwise);
+    bool SetRotation(Dim axis, int n, bool clockwise);
+
+    /**
+     * Apply a sequence of moves to a cube at once, with no animation. Any
+     * rotations under way or queued land first, unanimated, so that moves
+     * apply in the order they were made. The blocks are uploaded for drawing
+     * once, however long the sequence.
+     *
+     * @param moves The moves, which may be half turns.
+     * @param numMoves The number of moves.
+     * @return True if applied, false if any move is off the cube, in which
+     *    case none are.
+     */
+    bool ApplyMoves(const Move* moves, size_t numMoves);
 
     /**
      * Start a new rotation on a cube with randomly properties.
@@ -54,10 +91,69 @@ class Cube {
 
     /**
      * Update position and rotation values of blocks on a cube according to an 
-     * ongoing rotation.
+     * ongoing rotation, advancing it by one tick of 1 / TICKS_PER_SECOND
+     * seconds. Blocks stay in their starting poses until the rotation
+     * completes and are drawn turned by the rotation so far, so each tick
+     * costs the same regardless of cube size.
      */
     void UpdateRotation();
 
+    /**
+     * Set how fast rotations play, taking effect from the next rotation.
+     * Every rotation lasts at least one tick.
+     *
+     * @param movesPerSecond Quarter turns animated per second.
+     */
+    void SetMovesPerSecond(float movesPerSecond);
+
+    /**
+     * Set whether consecutive queued rotations of different slabs about the
+     * same axis turn together, up to MAX_PARALLEL_TURNS at once, taking
+     * effect from the next rotation.
+     *
+     * @param parallelTurns True to turn them together, false to turn one
+     *    slab at a time.
+     */
+    inline void SetParallelTurns(bool parallelTurns) {
+      m_parallelTurns = parallelTurns;
+    }
+
+    /**
+     * Set how queued rotations play, taking effect from the next rotation.
+     *
+     * @param playback The way of playing.
+     */
+    inline void SetPlayback(Playback playback) {
+      m_playback = playback;
+    }
+
+    /**
+     * Get how queued rotations play.
+     *
+     * @return The way of playing.
+     */
+    inline Playback GetPlayback() const {
+      return m_playback;
+    }
+
+    /**
+     * Get the number of rotations waiting to start.
+     *
+     * @return The queue depth, not counting rotations under way.
+     */
+    inline size_t GetQueueDepth() const {
+      return m_queue.size();
+    }
+
+    /**
+     * Get the number of rotations dropped because the queue was full.
+     *
+     * @return The count since the cube was made.
+     */
+    inline uint64_t GetDroppedMoves() const {
+      return m_droppedMoves;
+    }
+
     /**
      * Function to choose correct rotation to make on X or Z axes depending on
      * orientation at which a cube is viewed, and carry out that rotation.
@@ -78,14 +174,33 @@ class Cube {
                   glm::vec3& forward);
 
     /**
-     * Draw a cube to output.
+     * Set the color of the stickers which start on a face, for procedural
+     * shading.
+     *
+     * @param face The face.
+     * @param color The color.
+     */
+    inline void SetStickerColor(Face face, const glm::vec3& color) {
+      m_palette[face + 1] = color;
+    }
+
+    /**
+     * Draw the visible blocks of a cube to output. An instanced cube expects
+     * a shader accepting the per-instance attributes of MeshInstances, and
+     * ignores the transform. A procedural cube expects a shader taking face
+     * colors and a palette rather than a texture layer. A cube drawn from
+     * face textures expects a shader taking a box, highlights and a palette,
+     * and ignores the mesh.
      *
      * @param shader A shader.
      * @param transform A transform.
      * @param camera A camera.
      * @param mesh A mesh.
+     * @param interpolation Fraction of a tick since the last UpdateRotation,
+     *    drawn as that much more of an ongoing rotation.
      */
-    void Draw(Shader &shader, Transform &transform, Camera &camera, Mesh &mesh);
+    void Draw(Shader &shader, Transform &transform, Camera &camera, Mesh &mesh,
+              float interpolation = 0.0f);
 
     /**
      * Select the first block on a cube to intersect a ray.  Unselect a block
@@ -97,27 +212,69 @@ class Cube {
     void SelectBlock(const glm::vec3& rayStart, const glm::vec3& rayDir);
 
     /**
-     * Get the spacial position of a block on a cube.
+     * Highlight the first block on a cube to intersect a ray, or no block if
+     * none does. Cheap enough to call on every mouse motion.
+     *
+     * @param rayStart The origin of the ray.
+     * @param rayDir The direction of the ray (should be normalized).
+     */
+    void HoverBlock(const glm::vec3& rayStart, const glm::vec3& rayDir);
+
+    /**
+     * Find the first block on a cube to intersect a ray. The ray is clipped
+     * to the bounds of the cube and then walks the block grid one cell at a
+     * time, so the cost grows with the size of the cube rather than its
+     * volume.
+     *
+     * @param rayStart The origin of the ray.
+     * @param rayDir The direction of the ray.
+     * @param cell Position on the cube of the block hit (to be set).
+     * @return True if a block was hit, otherwise false.
+     */
+    bool PickBlock(const glm::vec3& rayStart, const glm::vec3& rayDir,
+                   glm::vec3& cell);
+
+    /**
+     * Get the spacial position of a block on the surface of a cube, turned
+     * by the rotation so far if its slab is turning. Not available for cubes
+     * drawn from face textures.
      *
      * @param x Position of desired block on cube along x-axis.
      * @param y Position of desired block on cube along y-axis.
      * @param z Position of desired block on cube along z-axis.
      * @return The position of the block.
      */
-    inline glm::vec3& GetPos(int x, int y, int z) {
-      return blocks[x][y][z]->GetPos();
-    }
+    glm::vec3 GetPos(int x, int y, int z) const;
 
     /**
-     * Get the rotation matrix of a block on a cube.
+     * Get the rotation matrix of a block on the surface of a cube, turned
+     * by the rotation so far if its slab is turning. Not available for cubes
+     * drawn from face textures.
      *
      * @param x Position of desired block on cube along x-axis.
      * @param y Position of desired block on cube along y-axis.
      * @param z Position of desired block on cube along z-axis.
      * @return The rotation matrix of the block.
      */
-    inline glm::mat4& GetRot(int x, int y, int z) {
-      return blocks[x][y][z]->GetRot();
+    glm::mat4 GetRot(int x, int y, int z) const;
+
+    /**
+     * Get the headless state of a cube, which mirrors every completed
+     * rotation of its blocks. It is kept flushed.
+     *
+     * @return The cube state.
+     */
+    inline const CubeState& GetState() const {
+      return m_state;
+    }
+
+    /**
+     * Check whether a cube is in the middle of a rotation.
+     *
+     * @return True if rotating, otherwise false.
+     */
+    inline bool IsRotating() const {
+      return currRotateSteps != 0;
     }
 
     /**
@@ -135,17 +292,231 @@ class Cube {
     ~Cube();
   protected:
   private:
+    /**
+     * Get the index of a block on the surface of a cube within the block
+     * arrays.
+     *
+     * @param x Position of desired block on cube along x-axis.
+     * @param y Position of desired block on cube along y-axis.
+     * @param z Position of desired block on cube along z-axis.
+     * @return The index of the block.
+     */
+    inline int Cell(int x, int y, int z) const {
+      return m_sliceTable->SurfaceIndex(x, y, z);
+    }
+
+    /**
+     * Get the index within the block arrays of a block given by its position
+     * on a cube, such as the selected block.
+     *
+     * @param cell Position of the block on the cube.
+     * @return The index of the block, or -1 if it is neither on the surface
+     *    nor exposed by the current rotation.
+     */
+    int BlockIndex(const glm::vec3& cell) const;
+
+    /**
+     * Get the index within the block arrays of an interior block exposed by
+     * the current rotation.
+     *
+     * @param layer Position of the block along the axis of rotation.
+     * @param cu Position along the axis following it.
+     * @param cv Position along the remaining axis.
+     * @return The index of the block, or -1 if its layer is not exposed.
+     */
+    int ExposedIndex(int layer, int cu, int cv) const;
+
+    /**
+     * Get the direction a slice is turning in.
+     *
+     * @param slice Slice along the axis of rotation.
+     * @return 1 if turning clockwise, -1 if counterclockwise, 0 if at rest.
+     */
+    inline int SliceTurn(int slice) const {
+      if (currRotateSteps == 0 || slice < 0 || slice >= size) {
+        return 0;
+      }
+      return m_sliceTurns[slice];
+    }
+
+    /**
+     * Start the rotations at the front of the queue: the first one, and
+     * when turning in parallel, those following it which turn other slabs
+     * about the same axis. Rotations which have not advanced yet are joined
+     * rather than restarted.
+     */
+    void StartQueuedTurns();
+
+    /**
+     * Rebuild the data on the slabs under rotation: the interior blocks they
+     * uncover, appended to the block arrays, and the runs of the block
+     * arrays which turn with each. Interior blocks are hidden at rest, so
+     * drawing costs grow with the surface of the cube rather than its
+     * volume.
+     */
+    void UpdateSlab();
+
+    /**
+     * Append the runs of surface blocks in a slab to the slab runs.
+     *
+     * @param n Slab along the axis of rotation.
+     */
+    void AddSlabRuns(int n);
+
+    /**
+     * Turn every block in a range of the slab runs a quarter turn about the
+     * axis of rotation, landing each exactly on its new cell and
+     * orientation.
+     *
+     * @param firstRun The first run to turn.
+     * @param lastRun One past the last run to turn.
+     * @param clockwise Turn clockwise if true, counterclockwise if false.
+     */
+    void QuarterTurnRuns(size_t firstRun, size_t lastRun, bool clockwise);
+
+    /**
+     * Move the surface blocks of a cube to their cells after a move, once
+     * the blocks of its slab have been turned.
+     *
+     * @param move The move.
+     */
+    void TurnBlockArrays(const Move& move);
+
+    /**
+     * Carry the selected block along with a move, if it is in the slab.
+     *
+     * @param move The move.
+     */
+    void TurnSelected(const Move& move);
+
+    /**
+     * Apply a sequence of moves to the state and blocks of a cube with no
+     * animation. No rotations may be under way.
+     *
+     * @param moves The moves.
+     * @param numMoves The number of moves, at least one.
+     */
+    void LandMoves(const Move* moves, size_t numMoves);
+
+    /**
+     * Get the angle the slabs under rotation have turned so far.
+     *
+     * @param interpolation Fraction of a tick past the last UpdateRotation.
+     * @return The magnitude of the angle.
+     */
+    float GetRotationAngle(float interpolation) const;
+
+    /**
+     * Get the rotation so far of the slabs turning in one direction.
+     *
+     * @param interpolation Fraction of a tick past the last UpdateRotation.
+     * @param clockwise The direction of turn.
+     * @return The rotation matrix, the identity if no slab is turning.
+     */
+    glm::mat4 GetSlabRotation(float interpolation, bool clockwise) const;
+
+    /**
+     * Draw a cube from its face textures: the whole cube as one box, or
+     * while slabs turn, each turning slab and each run of resting slices
+     * between them as a box of its own.
+     *
+     * @param shader A face texture shader.
+     * @param transform A transform.
+     * @param camera A camera.
+     * @param slabRotation Rotations of counterclockwise and clockwise
+     *    turning slabs to draw, in that order.
+     */
+    void DrawFaces(Shader& shader, Transform& transform, Camera& camera,
+                   const glm::mat4* slabRotation);
+
+    /**
+     * Draw part of a cube from its face textures.
+     *
+     * @param shader A face texture shader.
+     * @param transform A transform.
+     * @param camera A camera.
+     * @param boxMin The corner of the part with the lowest coordinates.
+     * @param boxMax The corner of the part with the highest coordinates.
+     * @param rot Rotation of the part about the center of the cube.
+     */
+    void DrawBox(Shader& shader, Transform& transform, Camera& camera,
+                 const glm::vec3& boxMin, const glm::vec3& boxMax,
+                 const glm::mat4& rot);
+
+    /**
+     * Create a mesh of a box from -1 to 1 along each axis, with one quad
+     * per face.
+     *
+     * @return The mesh.
+     */
+    static Mesh* CreateBox();
+
+    /**
+     * Set the drawn size of every block, enlarging the selected and hovered
+     * blocks.
+     */
+    void UpdateScales();
+
+    /**
+     * Upload the block arrays to a mesh as its per-instance data.
+     *
+     * @param mesh The mesh to be drawn once per block.
+     */
+    void UpdateInstances(Mesh& mesh);
+
     int size;
-    std::vector< std::vector< std::vector <Block*> > > blocks;
-    Texture* m_textures;
+    // Block data, as one array per field so that updates stream through only
+    // the fields they change and each array uploads as is to an instance
+    // buffer. Only blocks on the surface are stored, indexed by Cell(x, y, z),
+    // so memory grows with the surface of the cube rather than its volume.
+    // While a slab turns, the interior blocks it exposes follow them.
+    int m_numSurface;
+    int m_numBlocks;                     // Surface plus exposed blocks.
+    std::vector<float> m_posX;
+    std::vector<float> m_posY;
+    std::vector<float> m_posZ;
+    std::vector<uint8_t> m_orientation;  // Index into OrientationGroup.
+    std::vector<uint8_t> m_color;        // Col of each block.
+    std::vector<FaceColors> m_faceColors;
+    std::vector<float> m_scale;          // Drawn size of each block.
+    // Ranges [first, second) of the block arrays within the turning slabs,
+    // those of the k-th turn from m_slabRunStart[k] to m_slabRunStart[k + 1].
+    std::vector<std::pair<int, int> > m_slabRuns;
+    std::vector<size_t> m_slabRunStart;
+    std::vector<int> m_exposedLayers;  // Interior layers uncovered, in order.
+    CubeState m_state;
+    const SliceTable* m_sliceTable;
+    Texture* m_textures;  // NULL when shading procedurally.
+
+    // Procedural shading data. Sticker colors index the palette, whose first
+    // color is the plastic between stickers.
+    bool m_procedural;
+    glm::vec3 m_palette[NUM_FACES + 1];
 
     // Rotation data
     Dim  currRotateAxis;
-    int  currRotateN;
-    bool currRotateClockwise;
-    int  currRotateSteps;
+    int  currRotateSteps;      // Ticks left of the current rotation.
+    int  currRotateTicks;      // Ticks the current rotation lasts.
+    int  m_rotationTicks;      // Ticks each new rotation lasts.
+    std::deque<Move> m_queue;  // Rotations waiting to start.
+    std::vector<Move> m_turning;        // Rotations under way.
+    std::vector<int8_t> m_sliceTurns;   // SliceTurn of each slice.
+    glm::mat4 m_slabRotation[2];        // Per direction, rotation so far.
+    bool m_parallelTurns;
+    Playback m_playback;
+    uint64_t m_droppedMoves;
 
     glm::vec3 selected;
+    glm::vec3 m_hovered;  // Block under the mouse, or (-1, -1, -1).
+
+    // Face texture rendering data
+    bool m_faceTextures;
+    FaceTexture* m_faceTexture;  // NULL unless drawing face textures.
+    Mesh* m_box;                 // NULL unless drawing face textures.
+
+    // Instanced rendering data
+    bool m_instanced;
+    bool m_instancesDirty;  // Scales or instance buffers out of date.
 };
 
 #endif  // CUBE_H
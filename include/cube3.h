@@ -0,0 +1,249 @@
+/**
+ * @file cube3.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a compact facelet representation of
+ * a 3x3 cube, and of a move engine which applies face turns to it as vector
+ * byte shuffles.
+ */
+
+#ifndef CUBE3_H
+#define CUBE3_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "./cube_state.h"
+#include "./move.h"
+
+/**
+ * @enum The 18 face turns of a 3x3 cube: each face turned clockwise, half and
+ *    counterclockwise as seen when facing it.
+ */
+enum FaceTurn {
+  TURN_U1 = 0, TURN_U2, TURN_U3,
+  TURN_R1, TURN_R2, TURN_R3,
+  TURN_F1, TURN_F2, TURN_F3,
+  TURN_D1, TURN_D2, TURN_D3,
+  TURN_L1, TURN_L2, TURN_L3,
+  TURN_B1, TURN_B2, TURN_B3,
+
+  NUM_FACE_TURNS
+};
+
+/**
+ * Get the face of a face turn, numbered U R F D L B.
+ *
+ * @param turn The face turn.
+ * @return The face.
+ */
+inline int TurnFace(int turn) {
+  return turn / 3;
+}
+
+/**
+ * Check whether a face may be turned after another in a search. Turning a
+ * face twice in a row is never needed, and of two commuting opposite faces
+ * only one order is searched.
+ *
+ * @param face The face, numbered as by TurnFace.
+ * @param lastFace The face turned before it, or -1 for none.
+ * @return True if the face may be turned next, otherwise false.
+ */
+inline bool CanFollow(int face, int lastFace) {
+  return lastFace < 0 ||
+         (face != lastFace && face + 3 != lastFace);
+}
+
+/**
+ * Get the slice move equivalent to a face turn on a cube of any size.
+ *
+ * @param turn The face turn.
+ * @param size Number of blocks along each edge of the cube.
+ * @return The move.
+ */
+Move FaceTurnMove(FaceTurn turn, int size);
+
+/**
+ * Get the face turn equivalent to a slice move, if the move turns an outer
+ * slab.
+ *
+ * @param move The move.
+ * @param size Number of blocks along each edge of the cube.
+ * @param turn The face turn (to be set).
+ * @return True if the move is a face turn, false if it turns an inner slab
+ *    or does not turn at all.
+ */
+bool MoveFaceTurn(const Move& move, int size, FaceTurn& turn);
+
+/**
+ * The 54 facelets of a 3x3 cube, ordered as in CubeState and padded to fill
+ * a 64 byte vector register.
+ */
+struct Cube3 {
+  static const int NUM_FACELETS = NUM_FACES * 9;
+
+  /**
+   * Constructor for a solved cube.
+   */
+  Cube3();
+
+  /**
+   * Constructor from a headless cube state.
+   *
+   * @param state The state, of size 3.
+   */
+  explicit Cube3(const CubeState& state);
+
+  /**
+   * Check whether every face shows a single color.
+   *
+   * @return True if solved, otherwise false.
+   */
+  bool IsSolved() const;
+
+  bool operator==(const Cube3& other) const;
+  bool operator!=(const Cube3& other) const { return !(*this == other); }
+
+  uint8_t facelets[64];
+};
+
+/**
+ * A facelet permutation prepared for every instruction set the move engine
+ * may use. Applying it moves the facelet at sources[i] to facelet i.
+ */
+struct Cube3Shuffle {
+  /**
+   * Constructor for the identity permutation.
+   */
+  Cube3Shuffle();
+
+  /**
+   * Constructor for the permutation of a single face turn.
+   *
+   * @param turn The face turn.
+   */
+  explicit Cube3Shuffle(FaceTurn turn);
+
+  /**
+   * Recompute the vector masks after changing sources.
+   */
+  void Prepare();
+
+  uint8_t sources[64];       // Full 64 byte permutation (vpermb).
+  uint8_t ssse3[4][4][16];   // [output][input] 16 byte pshufb masks.
+  uint8_t avx2[2][4][32];    // [output][input] vpshufb masks; inputs are
+                             // each 32 byte half, then each half with its
+                             // 16 byte lanes swapped.
+};
+
+class Cube3Kernel {
+  public:
+    /**
+     * Get the move engine using the best instruction set supported by the
+     * processor. The choice is made once, on first use.
+     *
+     * @return The move engine.
+     */
+    static const Cube3Kernel& Get();
+
+    /**
+     * Constructor for a move engine using a given instruction set, falling
+     * back to the best supported set if the processor lacks it.
+     *
+     * @param instructionSet "avx512vbmi", "avx2", "ssse3" or "scalar", or
+     *    NULL for the best supported set.
+     */
+    explicit Cube3Kernel(const char* instructionSet);
+
+    /**
+     * Get the name of the instruction set in use.
+     *
+     * @return "avx512vbmi", "avx2", "ssse3" or "scalar".
+     */
+    inline const char* GetName() const { return m_name; }
+
+    /**
+     * Apply a face turn to a cube.
+     *
+     * @param cube The cube.
+     * @param turn The face turn.
+     */
+    inline void Apply(Cube3& cube, FaceTurn turn) const {
+      m_shuffle(cube.facelets, m_turns[turn]);
+    }
+
+    /**
+     * Apply a prepared permutation to a cube.
+     *
+     * @param cube The cube.
+     * @param shuffle The permutation.
+     */
+    inline void Apply(Cube3& cube, const Cube3Shuffle& shuffle) const {
+      m_shuffle(cube.facelets, shuffle);
+    }
+
+    /**
+     * Apply a sequence of face turns to a cube one by one, keeping the cube
+     * in registers throughout.
+     *
+     * @param cube The cube.
+     * @param turns The face turns (FaceTurn values).
+     * @param numTurns The number of face turns.
+     */
+    inline void Apply(Cube3& cube, const uint8_t* turns,
+                      size_t numTurns) const {
+      m_sequence(cube.facelets, m_turns, turns, numTurns);
+    }
+
+    /**
+     * Compose a sequence of face turns into a single permutation.
+     *
+     * @param turns The face turns (FaceTurn values).
+     * @param numTurns The number of face turns.
+     * @return The permutation.
+     */
+    Cube3Shuffle Compose(const uint8_t* turns, size_t numTurns) const;
+
+    /**
+     * Apply one sequence of face turns to many cubes. The sequence is
+     * composed once, then each cube is permuted with a single shuffle.
+     *
+     * @param cubes The cubes.
+     * @param numCubes The number of cubes.
+     * @param turns The face turns (FaceTurn values).
+     * @param numTurns The number of face turns.
+     */
+    void ApplyBatch(Cube3* cubes, size_t numCubes, const uint8_t* turns,
+                    size_t numTurns) const;
+
+    /**
+     * Apply a prepared permutation to many cubes.
+     *
+     * @param cubes The cubes.
+     * @param numCubes The number of cubes.
+     * @param shuffle The permutation.
+     */
+    inline void ApplyBatch(Cube3* cubes, size_t numCubes,
+                           const Cube3Shuffle& shuffle) const {
+      m_batch(cubes, numCubes, shuffle);
+    }
+  protected:
+  private:
+    typedef void (*ShuffleFunc)(uint8_t* facelets,
+                                const Cube3Shuffle& shuffle);
+    typedef void (*SequenceFunc)(uint8_t* facelets,
+                                 const Cube3Shuffle* turnShuffles,
+                                 const uint8_t* turns, size_t numTurns);
+    typedef void (*BatchFunc)(Cube3* cubes, size_t numCubes,
+                              const Cube3Shuffle& shuffle);
+
+    const char* m_name;
+    ShuffleFunc m_shuffle;
+    SequenceFunc m_sequence;
+    BatchFunc m_batch;
+    Cube3Shuffle m_turns[NUM_FACE_TURNS];
+};
+
+#endif  // CUBE3_H
@@ -0,0 +1,199 @@
+/**
+ * @file cube_state.h
+ * @author Charles Ian Mclees
+ *  
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a headless representation of the
+ * state of a Rubik's cube of any size, independent of OpenGL and SDL.
+ */
+
+#ifndef CUBE_STATE_H
+#define CUBE_STATE_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "./move.h"
+#include "./permutation.h"
+
+/**
+ * @enum Faces of a cube, ordered so that a face is (axis * 2) for the face on
+ *    the negative side of an axis, and (axis * 2 + 1) for the positive side.
+ */
+enum Face {
+  FACE_L = 0,  // -X
+  FACE_R,      // +X
+  FACE_D,      // -Y
+  FACE_U,      // +Y
+  FACE_B,      // -Z
+  FACE_F,      // +Z
+
+  NUM_FACES
+};
+
+class CubeState {
+  public:
+    /**
+     * Constructor for a solved cube state.
+     *
+     * @param size Number of blocks along each edge of the cube.
+     */
+    explicit CubeState(int size);
+
+    /**
+     * Return a cube state to the solved state.
+     */
+    void Reset();
+
+    /**
+     * Apply a move to a cube state. Only the 4 * size facelets around the
+     *    slab are moved; an outer slab's own face is turned lazily, by
+     *    counting the quarter turns it is behind, so every move costs
+     *    O(size).
+     *
+     * @param move The move. The slice must be between 0 and size.
+     */
+    void Apply(const Move& move);
+
+    /**
+     * Apply a sequence of moves to a cube state, in order.
+     *
+     * @param moves The moves.
+     * @param numMoves The number of moves.
+     */
+    void Apply(const Move* moves, size_t numMoves);
+
+    /**
+     * Apply a composed sequence of moves to a cube state in a single pass.
+     *
+     * @param permutation The permutation, built for the same cube size.
+     */
+    void Apply(const Permutation& permutation);
+
+    /**
+     * Check whether every face of a cube state shows a single color.
+     *
+     * @return True if solved, otherwise false.
+     */
+    bool IsSolved() const;
+
+    /**
+     * Get the size of a cube state.
+     *
+     * @return Number of blocks along each edge of the cube.
+     */
+    inline int GetSize() const { return m_size; }
+
+    /**
+     * Get the index of a facelet within the facelet array. The two
+     *    coordinates on a face are block positions along the remaining axes,
+     *    in X, Y, Z order.
+     *
+     * @param face The face.
+     * @param u Position along the first remaining axis.
+     * @param v Position along the second remaining axis.
+     * @return The index of the facelet.
+     */
+    inline int Index(Face face, int u, int v) const {
+      return (face * m_size + u) * m_size + v;
+    }
+
+    /**
+     * Get the color of a facelet, given as the face on which the facelet
+     *    starts in the solved state.
+     *
+     * @param face The face.
+     * @param u Position along the first remaining axis.
+     * @param v Position along the second remaining axis.
+     * @return The color of the facelet.
+     */
+    inline Face GetFacelet(Face face, int u, int v) const {
+      return static_cast<Face>(m_facelets[StoredIndex(face, u, v)]);
+    }
+
+    /**
+     * Bring the stored facelets of every face left behind by outer slab
+     *    turns up to date, at O(size^2) each, so that GetFacelets() may be
+     *    called. Const methods never do this themselves, so a const cube
+     *    state is safe to read from several threads at once.
+     */
+    void Flush();
+
+    /**
+     * Get every facelet of a cube state, NUM_FACES * size * size colors
+     *    ordered by face, then u, then v. No move may have been applied
+     *    since the last Flush().
+     *
+     * @return The facelets.
+     */
+    inline const std::vector<uint8_t>& GetFacelets() const {
+      assert(IsFlushed());
+      return m_facelets;
+    }
+
+    /**
+     * Write the facelets of a cube state as text, one line per face, with
+     *    each color written as the letter of its solved face (LRDUBF).
+     *
+     * @return The text.
+     */
+    std::string ToString() const;
+
+    bool operator==(const CubeState& other) const;
+
+    bool operator!=(const CubeState& other) const {
+      return !(*this == other);
+    }
+  protected:
+  private:
+    /**
+     * Get the index within the stored facelets of a facelet. A face whose
+     *    outer slab has been turned without moving its facelets is stored
+     *    rotated back by those turns.
+     *
+     * @param face The face.
+     * @param u Position along the first remaining axis.
+     * @param v Position along the second remaining axis.
+     * @return The index of the stored facelet.
+     */
+    inline int StoredIndex(Face face, int u, int v) const {
+      int last = m_size - 1;
+      for (int i = m_faceTurns[face]; i > 0; i--) {
+        // Undo one quarter turn of the face. The remaining axes of the Y
+        // faces are in the opposite order to the direction of a turn.
+        int t = u;
+        if (face == FACE_D || face == FACE_U) {
+          u = last - v;
+          v = t;
+        } else {
+          u = v;
+          v = last - t;
+        }
+      }
+      return Index(face, u, v);
+    }
+
+    /**
+     * Check whether every face is up to date.
+     *
+     * @return True if the stored facelets are laid out as Index() describes.
+     */
+    inline bool IsFlushed() const {
+      for (int face = 0; face < NUM_FACES; face++) {
+        if (m_faceTurns[face] != 0) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    int m_size;
+    std::vector<uint8_t> m_facelets;
+    std::vector<uint8_t> m_scratch;  // Reused when turning faces.
+    uint8_t m_faceTurns[NUM_FACES];  // Quarter turns each face is behind.
+};
+
+#endif  // CUBE_STATE_H
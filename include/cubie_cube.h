@@ -0,0 +1,177 @@
+/**
+ * @file cubie_cube.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a 3x3 cube described by the
+ * permutation and orientation of its corner and edge pieces (cubies), and of
+ * the coordinates used by the solvers to index move and pruning tables.
+ */
+
+#ifndef CUBIE_CUBE_H
+#define CUBIE_CUBE_H
+
+#include <stdint.h>
+#include "./cube3.h"
+
+/**
+ * @enum Corner positions, named for the faces they touch.
+ */
+enum Corner {
+  CORNER_URF = 0,
+  CORNER_UFL,
+  CORNER_ULB,
+  CORNER_UBR,
+  CORNER_DFR,
+  CORNER_DLF,
+  CORNER_DBL,
+  CORNER_DRB,
+
+  NUM_CORNERS
+};
+
+/**
+ * @enum Edge positions, named for the faces they touch. The last four make
+ *    up the slice between the U and D faces.
+ */
+enum Edge {
+  EDGE_UR = 0,
+  EDGE_UF,
+  EDGE_UL,
+  EDGE_UB,
+  EDGE_DR,
+  EDGE_DF,
+  EDGE_DL,
+  EDGE_DB,
+  EDGE_FR,
+  EDGE_FL,
+  EDGE_BL,
+  EDGE_BR,
+
+  NUM_EDGES
+};
+
+/**
+ * Number of values taken by each coordinate.
+ */
+const int NUM_TWISTS = 2187;         // 3^7 corner orientations.
+const int NUM_FLIPS = 2048;          // 2^11 edge orientations.
+const int NUM_SLICES = 495;          // 12 choose 4 slice edge positions.
+const int NUM_CORNER_PERMS = 40320;  // 8! corner permutations.
+const int NUM_EDGE8_PERMS = 40320;   // 8! permutations of the U and D edges.
+const int NUM_SLICE_PERMS = 24;      // 4! permutations of the slice edges.
+
+struct CubieCube {
+  /**
+   * Constructor for a solved cube.
+   */
+  CubieCube();
+
+  /**
+   * Read a cube from its facelets. Colors are taken relative to the center
+   * facelets, so a cube whose middle slices have turned is read as if the
+   * whole cube were turned back.
+   *
+   * @param cube The facelets.
+   * @param result The cube read (to be set).
+   * @return True if the facelets describe a solvable cube, otherwise false.
+   */
+  static bool FromFacelets(const Cube3& cube, CubieCube& result);
+
+  /**
+   * Write the facelets of a cube, with centers in their solved positions.
+   *
+   * @return The facelets.
+   */
+  Cube3 ToFacelets() const;
+
+  /**
+   * Get the cube reached by a single face turn from the solved cube.
+   *
+   * @param turn The face turn.
+   * @return The cube.
+   */
+  static const CubieCube& Turn(FaceTurn turn);
+
+  /**
+   * Apply another cube's permutation after this one's, so that applying a
+   * face turn is Multiply(Turn(turn)).
+   *
+   * @param other The permutation to apply.
+   */
+  void Multiply(const CubieCube& other);
+
+  /**
+   * Get the inverse of a cube, which undoes its permutation.
+   *
+   * @return The inverse.
+   */
+  CubieCube Inverse() const;
+
+  /**
+   * Check that pieces are a permutation with valid orientation and parity.
+   *
+   * @return True if solvable, otherwise false.
+   */
+  bool IsSolvable() const;
+
+  // Orientation of the first seven corners, in base 3.
+  int GetTwist() const;
+  void SetTwist(int twist);
+
+  // Orientation of the first eleven edges, in base 2.
+  int GetFlip() const;
+  void SetFlip(int flip);
+
+  // Positions of the four slice edges, ignoring their order.
+  int GetSlice() const;
+  void SetSlice(int slice);
+
+  // Permutation of the corners.
+  int GetCornerPerm() const;
+  void SetCornerPerm(int perm);
+
+  // Permutation of the eight U and D edges, which must lie in the U and D
+  // faces.
+  int GetEdge8Perm() const;
+  void SetEdge8Perm(int perm);
+
+  // Permutation of the four slice edges, which must lie in the slice.
+  int GetSlicePerm() const;
+  void SetSlicePerm(int perm);
+
+  uint8_t cp[NUM_CORNERS];  // Corner found at each corner position.
+  uint8_t co[NUM_CORNERS];  // Twist of the corner at each position, 0 to 2.
+  uint8_t ep[NUM_EDGES];    // Edge found at each edge position.
+  uint8_t eo[NUM_EDGES];    // Flip of the edge at each position, 0 or 1.
+};
+
+/**
+ * Get the rank of a permutation of n elements, 0 to n! - 1.
+ *
+ * @param perm The permutation of 0 to n - 1.
+ * @param n Number of elements, at most 12.
+ * @return The rank.
+ */
+int PermutationRank(const uint8_t* perm, int n);
+
+/**
+ * Set a permutation of n elements from its rank.
+ *
+ * @param rank The rank, 0 to n! - 1.
+ * @param n Number of elements, at most 12.
+ * @param perm The permutation of 0 to n - 1 (to be set).
+ */
+void PermutationUnrank(int rank, int n, uint8_t* perm);
+
+/**
+ * Get a binomial coefficient.
+ *
+ * @param n Number of elements.
+ * @param k Number chosen.
+ * @return n choose k, or 0 if k > n.
+ */
+int Choose(int n, int k);
+
+#endif  // CUBIE_CUBE_H
@@ -0,0 +1,77 @@
+/**
+ * @file face_texture.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a texture holding the sticker colors
+ * of every face of a cube, for drawing each face as a single quad.
+ */
+
+#ifndef FACE_TEXTURE_H
+#define FACE_TEXTURE_H
+
+#include <stdint.h>
+#include <vector>
+#include <GL/glew.h>
+#include "./cube_state.h"
+#include "./move.h"
+
+class FaceTexture {
+  public:
+    /**
+     * Constructor for a face texture, a texture array with one size * size
+     *    layer per face. Each texel holds the color of one facelet, as given
+     *    by CubeState, with texel (v, u) of a layer holding facelet (u, v) of
+     *    the face.
+     *
+     * @param state The cube state to show, flushed.
+     */
+    explicit FaceTexture(const CubeState& state);
+
+    /**
+     * Upload every facelet of a cube state.
+     *
+     * @param state The cube state, flushed and of the same size as the
+     *    texture.
+     */
+    void Update(const CubeState& state);
+
+    /**
+     * Upload only the facelets changed by a move: one row or column of each
+     *    face around the slab, and the whole face of an outer slab.
+     *
+     * @param state The cube state, with the move applied and flushed.
+     * @param move The move.
+     */
+    void Update(const CubeState& state, const Move& move);
+
+    /**
+     * Activate the texture array.
+     *
+     * @param unit Texture unit to be used.
+     */
+    void Bind(unsigned int unit);
+
+    /**
+     * Face texture destructor. Unload texture from graphics card via OpenGL.
+     */
+    ~FaceTexture();
+  protected:
+  private:
+    /**
+     * Upload the facelets of a face along one line through the slab of a
+     *    move.
+     *
+     * @param state The cube state.
+     * @param face The face, which must lie around the slab.
+     * @param move The move.
+     */
+    void UpdateLine(const CubeState& state, Face face, const Move& move);
+
+    int m_size;
+    GLuint m_texture;
+    std::vector<uint8_t> m_line;  // Facelets of one row or column to upload.
+};
+
+#endif  // FACE_TEXTURE_H
@@ -11,6 +11,7 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <stdint.h>
 #include <string>
 #include <glm/glm.hpp>
 #include <GL/glew.h>
@@ -62,6 +63,26 @@ class Vertex {
     glm::vec3 normal;    // Up direction on a surface.
 };
 
+/**
+ * Per-instance data used when drawing many copies of a mesh in one call. Each
+ * attribute is its own array, uploaded as is to its own buffer. Attributes a
+ * shader does not use may be left NULL.
+ */
+struct MeshInstances {
+  const float* posX;            // Position of each instance.
+  const float* posY;
+  const float* posZ;
+  const uint8_t* orientation;   // Rotation of each instance, as an index
+                                // into a table of matrices held by the
+                                // shader.
+  const uint8_t* texture;       // Texture array layer to sample.
+  const float* scale;           // Uniform scale applied before the rotation.
+  const uint8_t* faceColors;    // Palette index of each of six faces, for
+                                // shaders which color faces procedurally
+                                // rather than sample textures.
+  unsigned int count;
+};
+
 /**
  * Main mesh class.
  */
@@ -90,6 +111,20 @@ class Mesh {
      */
     void Draw();
 
+    /**
+     * Replace the per-instance data used by DrawInstanced. Only attributes
+     *    which have been given data are read by the shader; the others, and
+     *    every attribute of a mesh never given instances, are left disabled.
+     *
+     * @param instances Data for each instance of the mesh.
+     */
+    void SetInstances(const MeshInstances& instances);
+
+    /**
+     * Render every instance given to SetInstances with a single draw call.
+     */
+    void DrawInstanced();
+
     /**
      * Destructor for a mesh.
      */
@@ -103,6 +138,36 @@ class Mesh {
      */
     void InitMesh(const IndexedModel& model);
 
+    /**
+     * Replace the contents of one per-instance buffer.
+     *
+     * @param buffer The buffer.
+     * @param data The new contents, or NULL to leave the buffer as it is.
+     * @param numBytes The size of the new contents.
+     */
+    void UploadInstanceBuffer(int buffer, const void* data, size_t numBytes);
+
+    /**
+     * Source the per-instance attributes held by one of the instance buffers
+     *    from it. The mesh's vertex array must be bound.
+     *
+     * @param buffer The buffer.
+     */
+    void InitInstanceAttributes(int buffer);
+
+    /**
+     * Source a per-instance attribute from one of the instance buffers.
+     *
+     * @param location The attribute location.
+     * @param buffer The buffer.
+     * @param components Number of components of the attribute.
+     * @param type Type of each component within the buffer.
+     * @param stride Bytes between consecutive instances.
+     * @param offset Bytes to the first instance's value.
+     */
+    void InitInstanceAttribute(GLuint location, int buffer, GLint components,
+                               GLenum type, GLsizei stride, size_t offset);
+
     /**
      * @enum OpenGL data buffers for an initialized mesh.
      */
@@ -111,6 +176,13 @@ class Mesh {
       TEXCOORD_VB,
       NORMAL_VB,
       INDEX_VB,
+      INSTANCE_POSX_VB,
+      INSTANCE_POSY_VB,
+      INSTANCE_POSZ_VB,
+      INSTANCE_ORIENTATION_VB,
+      INSTANCE_TEXTURE_VB,
+      INSTANCE_SCALE_VB,
+      INSTANCE_FACECOLORS_VB,
 
       NUM_BUFFERS
     };
@@ -118,6 +190,8 @@ class Mesh {
     GLuint m_vertexArrayObject;
     GLuint m_vertexArrayBuffers[NUM_BUFFERS];
     unsigned int m_drawCount;
+    unsigned int m_numInstances;
+    bool m_instanceBufferUsed[NUM_BUFFERS];  // True once a buffer is filled.
 };
 
 #endif  // MESH_H
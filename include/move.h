@@ -0,0 +1,49 @@
+/**
+ * @file move.h
+ * @author Charles Ian Mclees
+ *  
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a single slice turn of a Rubik's
+ * cube of any size.
+ */
+
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <stdint.h>
+
+/**
+ * @enum Dimensions of rotation and translation.
+ */
+enum Dim {
+  X = 0,
+  Y = 1,
+  Z = 2
+};
+
+/**
+ * A single turn of one slab of a cube.
+ */
+struct Move {
+  Move() : slice(0), axis(X), turns(0) {}
+
+  /**
+   * Constructor for a move.
+   *
+   * @param axis Axis about which to rotate.
+   * @param slice Slab of blocks between 0 and size to be rotated.
+   * @param turns Number of clockwise quarter turns, 1 to 3. Clockwise is a
+   *    positive (right handed) rotation about the axis.
+   */
+  Move(Dim axis, int slice, int turns) :
+    slice(static_cast<uint16_t>(slice)),
+    axis(static_cast<uint8_t>(axis)),
+    turns(static_cast<uint8_t>(turns & 3)) {}
+
+  uint16_t slice;
+  uint8_t axis;
+  uint8_t turns;
+};
+
+#endif  // MOVE_H
@@ -0,0 +1,92 @@
+/**
+ * @file notation.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a reader of move sequences written
+ * in standard (WCA and SiGN) notation for a cube of any size.
+ */
+
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "./move.h"
+
+/**
+ * Compiles text in WCA or SiGN notation to moves of a cube of a given size.
+ * A turn is a letter with an optional layer prefix and amount suffix:
+ *
+ *   R U F L D B      Outer face, a quarter turn clockwise facing the face.
+ *   R2 R' R2' R3     Half turn, counterclockwise, or any number of turns.
+ *   Rw r 3Rw 3r      The outer two layers, or outer n layers, together.
+ *   2R 2-3Rw 2-3r    The second layer alone, or layers two to three.
+ *   x y z            The whole cube, turning as R, U and F do.
+ *   M E S            Every inner layer, turning as L, D and F do.
+ *
+ * Turns may be separated by whitespace or written back to back. Every layer
+ * of a turn compiles to a Move of its own, so a sequence becomes a flat array
+ * of 4 byte moves ready for CubeState::Apply or Permutation.
+ */
+class Notation {
+  public:
+    /**
+     * Constructor for a reader of moves of a cube size.
+     *
+     * @param size Number of blocks along each edge of the cube.
+     */
+    explicit Notation(int size);
+
+    /**
+     * Compile text to moves. The text is scanned in place, one character at
+     *    a time, so nothing is allocated per turn.
+     *
+     * @param text The text.
+     * @param length The number of characters of text.
+     * @param moves The moves, appended to in order (to be set).
+     * @param error Why the text could not be read (to be set on failure).
+     * @return True if all of the text was read, otherwise false, with the
+     *    moves before the first unreadable turn appended.
+     */
+    bool Parse(const char* text, size_t length, std::vector<Move>& moves,
+               std::string& error) const;
+
+    /**
+     * Compile text to moves.
+     *
+     * @param text The text.
+     * @param moves The moves, appended to in order (to be set).
+     * @param error Why the text could not be read (to be set on failure).
+     * @return True if all of the text was read, otherwise false.
+     */
+    inline bool Parse(const std::string& text, std::vector<Move>& moves,
+                      std::string& error) const {
+      return Parse(text.data(), text.size(), moves, error);
+    }
+
+    /**
+     * Compile a file of text to moves, reading it whole.
+     *
+     * @param fileName Name of the file.
+     * @param moves The moves, appended to in order (to be set).
+     * @param error Why the file could not be read (to be set on failure).
+     * @return True if all of the file was read, otherwise false.
+     */
+    bool ParseFile(const std::string& fileName, std::vector<Move>& moves,
+                   std::string& error) const;
+
+    /**
+     * Get the size of cube moves are compiled for.
+     *
+     * @return Number of blocks along each edge of the cube.
+     */
+    inline int GetSize() const { return m_size; }
+  protected:
+  private:
+    int m_size;
+};
+
+#endif  // NOTATION_H
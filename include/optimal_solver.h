@@ -0,0 +1,315 @@
+/**
+ * @file optimal_solver.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of Korf's optimal solver for the 3x3
+ * cube: iterative deepening A* guided by pattern databases for the corners
+ * and for two groups of edges. Deep iterations are split into tasks which
+ * are searched in parallel.
+ */
+
+#ifndef OPTIMAL_SOLVER_H
+#define OPTIMAL_SOLVER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "./cube3.h"
+#include "./cubie_cube.h"
+#include "./pattern_database.h"
+
+class OptimalSolver {
+  public:
+    /**
+     * Statistics of a solve.
+     */
+    struct SearchStats {
+      uint64_t nodes;   // Nodes searched, over every thread.
+      double seconds;   // Time taken.
+      int numThreads;   // Threads searched with.
+    };
+
+    /**
+     * Constructor for a solver. Its pattern databases must be loaded before
+     * solving.
+     *
+     * @param edgeGroupSize Number of edges in each edge pattern database,
+     *    6 or 7. Seven edge databases are 12 times larger (255 MB each) and
+     *    make the search several times faster.
+     * @param numThreads Number of threads to search with, or 0 for one per
+     *    core.
+     * @param deterministic True to always return the solution a single
+     *    thread would find. Otherwise the first shortest solution found by
+     *    any thread is returned, which may differ from run to run.
+     */
+    explicit OptimalSolver(int edgeGroupSize = 7, int numThreads = 0,
+                           bool deterministic = false);
+
+    /**
+     * Map the pattern databases from a directory, building and writing any
+     * which are missing. Building takes minutes; mapping takes
+     * milliseconds.
+     *
+     * @param directory Directory holding the database files.
+     * @param build True to build missing databases, false to fail instead.
+     * @param verify True to check each file's checksum, which reads the
+     *    whole file.
+     * @return True if every database was loaded, otherwise false.
+     */
+    bool Load(const std::string& directory = "./data/table",
+              bool build = true, bool verify = false);
+
+    /**
+     * Find a shortest solution for a cube.
+     *
+     * @param state The cube, of size 3.
+     * @param solution The face turns solving the cube (to be set).
+     * @param maxLength Give up if every solution is longer than this.
+     * @param stats Statistics of the search (to be set), or NULL.
+     * @return True if a solution was found, false if the cube is unsolvable
+     *    or needs more than maxLength moves.
+     */
+    bool Solve(const CubeState& state, std::vector<FaceTurn>& solution,
+               int maxLength = 20, SearchStats* stats = NULL) const;
+    bool Solve(const Cube3& cube, std::vector<FaceTurn>& solution,
+               int maxLength = 20, SearchStats* stats = NULL) const;
+    bool Solve(const CubieCube& cube, std::vector<FaceTurn>& solution,
+               int maxLength = 20, SearchStats* stats = NULL) const;
+
+    /**
+     * Solve cubes on a single thread and then on every thread of the
+     * solver, printing the time taken and speedup for each.
+     *
+     * @param cubes The cubes.
+     * @param maxLength Give up on cubes needing more moves than this.
+     */
+    void Benchmark(const std::vector<CubieCube>& cubes,
+                   int maxLength = 20) const;
+
+    /**
+     * Get the number of threads the solver searches with.
+     *
+     * @return The number of threads.
+     */
+    inline int GetNumThreads() const {
+      return m_numThreads;
+    }
+  protected:
+  private:
+    // Most moves made by a task before its subtree is searched.
+    static const int MAX_SPLIT_DEPTH = 4;
+
+    /**
+     * A group of corners or edges, indexed by the positions and
+     * orientations of its pieces.
+     */
+    struct PieceGroup {
+      bool corners;          // Corners if true, otherwise edges.
+      int first;             // First piece of the group.
+      int count;             // Number of pieces in the group.
+      int numPositions;      // 8 for corners, 12 for edges.
+      int numOrientations;   // 3 for corners, 2 for edges.
+      int orientedPieces;    // Pieces whose orientation is stored; the last
+                             // is implied when the group has every piece.
+      uint32_t pattern;      // Identifies the group in database files.
+      uint64_t numOrientationSets;
+      uint64_t numEntries;
+    };
+
+    class GroupSpace;
+    class TaskQueue;
+    class WorkerPool;
+
+    /**
+     * Positions and orientations of every piece, indexed by piece.
+     */
+    struct PieceState {
+      uint8_t cornerPos[NUM_CORNERS];
+      uint8_t cornerOri[NUM_CORNERS];
+      uint8_t edgePos[NUM_EDGES];
+      uint8_t edgeOri[NUM_EDGES];
+    };
+
+    /**
+     * A subtree of an iteration, searched by one thread: the moves leading
+     * to it and the cube they reach.
+     */
+    struct SearchTask {
+      PieceState state;
+      uint8_t moves[MAX_SPLIT_DEPTH];
+    };
+
+    /**
+     * The task a thread is searching, and what is shared with the other
+     * threads searching the iteration.
+     */
+    struct SearchContext {
+      // Lowest numbered task which has found a solution, or the number of
+      // tasks if none has. NULL when searching on a single thread.
+      const std::atomic<uint64_t>* firstSolved;
+      uint64_t priority;  // The task is cancelled once firstSolved is lower.
+      uint64_t nodes;     // Nodes searched by the thread.
+    };
+
+    /**
+     * Set up a piece group.
+     *
+     * @param corners Corners if true, otherwise edges.
+     * @param first First piece of the group.
+     * @param count Number of pieces in the group.
+     * @return The group.
+     */
+    static PieceGroup MakeGroup(bool corners, int first, int count);
+
+    /**
+     * Get the database index of a piece group.
+     *
+     * @param group The group.
+     * @param pos Position of each piece of the group's kind.
+     * @param ori Orientation of each piece of the group's kind.
+     * @return The index.
+     */
+    static uint64_t GroupIndex(const PieceGroup& group, const uint8_t* pos,
+                               const uint8_t* ori);
+
+    /**
+     * Set the positions and orientations of a piece group from its index.
+     *
+     * @param group The group.
+     * @param index The index.
+     * @param pos Position of each piece of the group's kind (to be set).
+     * @param ori Orientation of each piece of the group's kind (to be set).
+     */
+    static void GroupFromIndex(const PieceGroup& group, uint64_t index,
+                               uint8_t* pos, uint8_t* ori);
+
+    /**
+     * Apply a face turn to pieces.
+     *
+     * @param corners Corners if true, otherwise edges.
+     * @param turn The face turn.
+     * @param pos Position of each piece (to be updated).
+     * @param ori Orientation of each piece (to be updated).
+     * @param first First piece to turn.
+     * @param count Number of pieces to turn.
+     */
+    void TurnPieces(bool corners, int turn, uint8_t* pos, uint8_t* ori,
+                    int first, int count) const;
+
+    /**
+     * Get the lower bound on moves to solve a cube given by the databases.
+     *
+     * @param state The cube.
+     * @return The bound.
+     */
+    int Distance(const PieceState& state) const;
+
+    /**
+     * Get the lower bound on moves to solve a cube given by one database.
+     *
+     * @param state The cube. Only the pieces of the group need be current.
+     * @param group The database: 0 for corners, 1 and 2 for the edges.
+     * @return The bound.
+     */
+    int GroupDistance(const PieceState& state, int group) const;
+
+    /**
+     * Find a shortest solution for a cube on a given number of threads.
+     *
+     * @param cube The cube.
+     * @param solution The face turns solving the cube (to be set).
+     * @param maxLength Give up if every solution is longer than this.
+     * @param numThreads Number of threads to search with.
+     * @param stats Statistics of the search (to be set), or NULL.
+     * @return True if a solution was found.
+     */
+    bool SolveWithThreads(const CubieCube& cube,
+                          std::vector<FaceTurn>& solution, int maxLength,
+                          int numThreads, SearchStats* stats) const;
+
+    /**
+     * Search every solution of a given length, splitting the search into
+     * tasks if it is to run on more than one thread.
+     *
+     * @param start The cube.
+     * @param length Length of the solutions.
+     * @param numThreads Number of threads to search with.
+     * @param pool Threads other than the calling one to search with, one
+     *    fewer than numThreads.
+     * @param moves The solution, length face turns (to be set if found).
+     * @param nodes Nodes searched (to be incremented).
+     * @return True if a solution was found.
+     */
+    bool SearchIteration(const PieceState& start, int length, int numThreads,
+                         WorkerPool* pool, uint8_t* moves,
+                         uint64_t* nodes) const;
+
+    /**
+     * Split an iteration into tasks, in the order a single thread would
+     * search them. Tasks which the databases show cannot lead to a
+     * solution are left out.
+     *
+     * @param start The cube.
+     * @param length Length of the solutions.
+     * @param numTasks Split until there are at least this many tasks.
+     * @param tasks The tasks (to be set).
+     * @return Number of moves made by each task.
+     */
+    int MakeTasks(const PieceState& start, int length, size_t numTasks,
+                  std::vector<SearchTask>& tasks) const;
+
+    /**
+     * Search tasks on one thread until no thread has any left, taking them
+     * first from the thread's own queue and then from the others'.
+     *
+     * @param tasks The tasks of the iteration.
+     * @param splitDepth Number of moves made by each task.
+     * @param length Length of the solutions.
+     * @param queues Queue of task numbers of each thread.
+     * @param worker Index of the thread's own queue.
+     * @param deterministic True to keep searching tasks numbered below the
+     *    first which has found a solution.
+     * @param firstSolved Lowest numbered task which has found a solution.
+     * @param solution The solution of that task (to be set).
+     * @param solutionMutex Guards firstSolved and solution when solved.
+     * @param nodes Nodes searched by the thread (to be set).
+     */
+    void SearchTasks(const std::vector<SearchTask>* tasks, int splitDepth,
+                     int length, std::vector<TaskQueue>* queues, int worker,
+                     bool deterministic, std::atomic<uint64_t>* firstSolved,
+                     uint8_t* solution, std::mutex* solutionMutex,
+                     uint64_t* nodes) const;
+
+    /**
+     * Search for solutions of a given length.
+     *
+     * @param states State at each depth of the search.
+     * @param moves Face turn made at each depth (to be set).
+     * @param depth Number of moves made so far.
+     * @param togo Number of moves left, at least the Distance() of the cube.
+     * @param context The task being searched.
+     * @return True if a solution was found, false if none was or the task
+     *    was cancelled.
+     */
+    bool Search(PieceState* states, uint8_t* moves, int depth, int togo,
+                SearchContext& context) const;
+
+    int m_edgeGroupSize;
+    int m_numThreads;
+    bool m_deterministic;
+    PieceGroup m_groups[3];      // Corners, low edges and high edges.
+    PatternDatabase m_databases[3];
+
+    // Where each face turn carries the piece at each position, and the
+    // orientation it adds.
+    uint8_t m_cornerPosMove[NUM_FACE_TURNS][NUM_CORNERS];
+    uint8_t m_cornerOriMove[NUM_FACE_TURNS][NUM_CORNERS];
+    uint8_t m_edgePosMove[NUM_FACE_TURNS][NUM_EDGES];
+    uint8_t m_edgeOriMove[NUM_FACE_TURNS][NUM_EDGES];
+};
+
+#endif  // OPTIMAL_SOLVER_H
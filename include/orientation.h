@@ -0,0 +1,78 @@
+/**
+ * @file orientation.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of the group of 24 rotations which
+ * carry a cube onto itself, used to orient blocks.
+ */
+
+#ifndef ORIENTATION_H
+#define ORIENTATION_H
+
+#include <stdint.h>
+#include <glm/glm.hpp>
+#include "./move.h"
+
+/**
+ * The 24 orientations a block can rest in, each named by a one-byte index,
+ * with 0 the orientation blocks start in. Quarter turns between them are
+ * looked up rather than multiplied, so a block's orientation is always exact.
+ */
+class OrientationGroup {
+  public:
+    static const int NUM_ORIENTATIONS = 24;
+
+    /**
+     * Get the shared group, building its tables on first use. Safe to call
+     * from multiple threads.
+     *
+     * @return The group.
+     */
+    static const OrientationGroup& Get();
+
+    /**
+     * Get the orientation reached by a quarter turn of a block.
+     *
+     * @param orientation Orientation of the block before the turn.
+     * @param axis Axis about which the block turns.
+     * @param clockwise Turn clockwise if true, counterclockwise if false.
+     * @return Orientation of the block after the turn.
+     */
+    inline uint8_t Turn(uint8_t orientation, Dim axis, bool clockwise) const {
+      return m_turns[orientation][axis][clockwise ? 1 : 0];
+    }
+
+    /**
+     * Get the rotation matrix of an orientation.
+     *
+     * @param orientation The orientation.
+     * @return The rotation matrix.
+     */
+    inline const glm::mat4& Matrix(uint8_t orientation) const {
+      return m_matrices[orientation];
+    }
+
+    /**
+     * Get the rotation matrices of every orientation, in order of index, for
+     * upload to a shader.
+     *
+     * @return The NUM_ORIENTATIONS matrices.
+     */
+    inline const glm::mat4* Matrices() const {
+      return m_matrices;
+    }
+  protected:
+  private:
+    /**
+     * Constructor for the group, which enumerates every orientation reached
+     * by quarter turns from the starting one.
+     */
+    OrientationGroup();
+
+    uint8_t m_turns[NUM_ORIENTATIONS][3][2];  // [orientation][axis][clockwise]
+    glm::mat4 m_matrices[NUM_ORIENTATIONS];
+};
+
+#endif  // ORIENTATION_H
@@ -0,0 +1,152 @@
+/**
+ * @file pattern_database.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a pattern database: a table of the
+ * number of moves needed to solve some subset of a cube's pieces, stored in
+ * a file which is memory-mapped rather than read into the heap.
+ */
+
+#ifndef PATTERN_DATABASE_H
+#define PATTERN_DATABASE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Header at the start of a pattern database file. The table follows at
+ * dataOffset, packed two 4 bit entries per byte, low nibble first.
+ */
+struct PatternFileHeader {
+  static const uint32_t MAGIC = 0x42445052;  // "RPDB"
+  static const uint32_t VERSION = 2;
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t pattern;     // Identifies which pieces the table covers.
+  uint32_t reserved;
+  uint64_t numEntries;
+  uint64_t dataOffset;  // A multiple of the page size.
+  uint64_t checksum;    // Checksum() of the packed table.
+};
+
+class PatternDatabase {
+  public:
+    /**
+     * Constructor for an empty database.
+     */
+    PatternDatabase();
+
+    /**
+     * Map a database file into memory. The file's pages are shared with any
+     * other process mapping it, and are only read from disk when touched.
+     *
+     * @param path Path of the file.
+     * @param pattern Expected pattern identifier.
+     * @param numEntries Expected number of entries.
+     * @param verify True to check the table against the checksum in its
+     *    header, which reads the whole file.
+     * @return True if the file was mapped, false if it is missing, does
+     *    not match or is corrupt.
+     */
+    bool Open(const std::string& path, uint32_t pattern, uint64_t numEntries,
+              bool verify = false);
+
+    /**
+     * Use a table held in memory rather than a file.
+     *
+     * @param table Packed entries, taken from the vector (to be emptied).
+     */
+    void Adopt(std::vector<uint8_t>& table);
+
+    /**
+     * Unmap the database file, if any.
+     */
+    void Close();
+
+    /**
+     * Write a database file. The file is written under a unique temporary
+     *    name and renamed into place, so other processes never map a partial
+     *    file.
+     *
+     * @param path Path of the file.
+     * @param pattern Pattern identifier.
+     * @param table Packed entries.
+     * @param numEntries Number of entries.
+     * @return True if written, otherwise false.
+     */
+    static bool Write(const std::string& path, uint32_t pattern,
+                      const std::vector<uint8_t>& table, uint64_t numEntries);
+
+    /**
+     * Get the checksum of a packed table.
+     *
+     * @param table The packed entries.
+     * @param size Size of the table in bytes.
+     * @return The checksum.
+     */
+    static uint64_t Checksum(const uint8_t* table, size_t size);
+
+    /**
+     * Get an entry from a packed table.
+     *
+     * @param table The packed entries.
+     * @param index Index of the entry.
+     * @return The entry, 0 to 15.
+     */
+    static inline int Get(const uint8_t* table, uint64_t index) {
+      return (table[index >> 1] >> ((index & 1) << 2)) & 0xF;
+    }
+
+    /**
+     * Set an entry in a packed table.
+     *
+     * @param table The packed entries.
+     * @param index Index of the entry.
+     * @param value The entry, 0 to 15.
+     */
+    static inline void Set(uint8_t* table, uint64_t index, int value) {
+      int shift = (index & 1) << 2;
+      table[index >> 1] = (table[index >> 1] & ~(0xF << shift)) |
+                          (value << shift);
+    }
+
+    /**
+     * Get an entry of the database.
+     *
+     * @param index Index of the entry.
+     * @return The entry.
+     */
+    inline int Get(uint64_t index) const {
+      return Get(m_data, index);
+    }
+
+    /**
+     * Check whether a database file is mapped.
+     *
+     * @return True if mapped, otherwise false.
+     */
+    inline bool IsOpen() const {
+      return m_data != NULL;
+    }
+
+    /**
+     * Descructor for a database, unmapping its file.
+     */
+    ~PatternDatabase();
+  protected:
+  private:
+    PatternDatabase(const PatternDatabase&);
+    PatternDatabase& operator=(const PatternDatabase&);
+
+    void* m_map;
+    size_t m_mapSize;
+    std::vector<uint8_t> m_table;  // Table held in memory, if not mapped.
+    const uint8_t* m_data;
+};
+
+#endif  // PATTERN_DATABASE_H
@@ -0,0 +1,99 @@
+/**
+ * @file permutation.h
+ * @author Charles Ian Mclees
+ *  
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a permutation of the facelets of a
+ * cube, used to apply a whole sequence of moves at once.
+ */
+
+#ifndef PERMUTATION_H
+#define PERMUTATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "./move.h"
+
+class Permutation {
+  public:
+    /**
+     * Constructor for the identity permutation of a cube size.
+     *
+     * @param size Number of blocks along each edge of the cube.
+     */
+    explicit Permutation(int size);
+
+    /**
+     * Constructor for the permutation equivalent to a sequence of moves.
+     *
+     * @param size Number of blocks along each edge of the cube.
+     * @param moves The moves, in the order they are to be applied.
+     * @param numMoves The number of moves.
+     */
+    Permutation(int size, const Move* moves, size_t numMoves);
+
+    /**
+     * Extend a permutation by a move, as if the move were applied after it.
+     *
+     * @param move The move.
+     */
+    void Apply(const Move& move);
+
+    /**
+     * Extend a permutation by another, as if the other were applied after
+     *    it.
+     *
+     * @param next The permutation to follow, of the same cube size.
+     */
+    void Then(const Permutation& next);
+
+    /**
+     * Get the inverse of a permutation, which undoes it.
+     *
+     * @return The inverse.
+     */
+    Permutation Inverse() const;
+
+    /**
+     * Get the order of a permutation: the number of times it must be
+     *    applied to a solved cube before the cube is solved again, counting
+     *    every facelet as distinct. Found from the lengths of its cycles, so
+     *    it costs one pass over the facelets.
+     *
+     * @return The order, or 0 if it does not fit in 64 bits.
+     */
+    uint64_t Order() const;
+
+    /**
+     * Get the source of every facelet: applying a permutation moves the
+     *    facelet at GetSources()[i] to facelet i.
+     *
+     * @return The sources.
+     */
+    inline const std::vector<uint32_t>& GetSources() const {
+      return m_sources;
+    }
+
+    /**
+     * Get the size of cube a permutation applies to.
+     *
+     * @return Number of blocks along each edge of the cube.
+     */
+    inline int GetSize() const { return m_size; }
+
+    bool operator==(const Permutation& other) const {
+      return m_size == other.m_size && m_sources == other.m_sources;
+    }
+
+    bool operator!=(const Permutation& other) const {
+      return !(*this == other);
+    }
+  protected:
+  private:
+    int m_size;
+    std::vector<uint32_t> m_sources;
+};
+
+#endif  // PERMUTATION_H
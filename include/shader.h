@@ -10,6 +10,7 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <stdint.h>
 #include <string>
 #include <GL/glew.h>
 #include "./transform.h"
@@ -17,6 +18,10 @@
 
 class Shader {
   public:
+    // Most slabs a shader can turn at once, defined as MAX_SLICES in the
+    // text of every shader so that its slice arrays are sized to match.
+    static const int MAX_SLICES = 8;
+
     /**
      * Constructor for a shader.
      *
@@ -40,6 +45,76 @@ class Shader {
      */
     void Update(const Transform& transform, const Camera& camera);
 
+    /**
+     * Update a shader to reflect camera angle and position only, for use with
+     *    instanced meshes which carry their own model matrices.
+     *
+     * @param camera Active camera object.
+     */
+    void Update(const Camera& camera);
+
+    /**
+     * Update the rotations applied by a shader to slabs of instances, those
+     *    whose position along the axis matches a slab position.
+     *
+     * @param axis Unit axis of rotation.
+     * @param positions Position of each slab along the axis.
+     * @param angles Current angle of rotation of each slab, 0 for none.
+     * @param numSlices The number of slabs, at most MAX_SLICES.
+     */
+    void UpdateSlices(const glm::vec3& axis, const float* positions,
+                      const float* angles, int numSlices);
+
+    /**
+     * Update the texture array layer sampled by a shader, for meshes drawn
+     *    without per-instance layers.
+     *
+     * @param layer The layer.
+     */
+    void UpdateLayer(int layer);
+
+    /**
+     * Update the sticker colors used by a procedural shader for meshes drawn
+     *    without per-instance face colors.
+     *
+     * @param faceColors Palette index of each face, in the order of Face.
+     */
+    void UpdateFaceColors(const uint8_t* faceColors);
+
+    /**
+     * Update the palette of sticker colors used by a procedural shader.
+     *
+     * @param colors The colors, the first for faces without a sticker.
+     * @param numColors The number of colors.
+     */
+    void UpdatePalette(const glm::vec3* colors, int numColors);
+
+    /**
+     * Update the table of rotation matrices which instanced shaders index
+     *    by each instance's orientation.
+     *
+     * @param matrices The matrices.
+     * @param numMatrices The number of matrices.
+     */
+    void UpdateOrientations(const glm::mat4* matrices, int numMatrices);
+
+    /**
+     * Update the part of a cube drawn by a face texture shader, as a box in
+     *    the cube's own coordinates.
+     *
+     * @param min The corner of the box with the lowest coordinates.
+     * @param max The corner of the box with the highest coordinates.
+     */
+    void UpdateBox(const glm::vec3& min, const glm::vec3& max);
+
+    /**
+     * Update the blocks highlighted by a face texture shader.
+     *
+     * @param selected Position on the cube of the selected block.
+     * @param hovered Position on the cube of the block under the mouse.
+     */
+    void UpdateHighlight(const glm::vec3& selected, const glm::vec3& hovered);
+
     /**
      * Descructor for a shader object. Unload shader from graphics card
      *    via OpenGL.
@@ -54,6 +129,19 @@ class Shader {
      */
     enum {
       TRANSFORM_U,
+      VIEWPROJECTION_U,
+      SLICEAXIS_U,
+      SLICEPOS_U,
+      SLICEANGLE_U,
+      LAYER_U,
+      FACECOLORS0_U,
+      FACECOLORS1_U,
+      PALETTE_U,
+      BOXMIN_U,
+      BOXMAX_U,
+      SELECTED_U,
+      HOVERED_U,
+      ORIENTATIONS_U,
 
       NUM_UNIFORMS
     };
@@ -0,0 +1,235 @@
+/**
+ * @file slice_table.h
+ * @author Charles Ian Mclees
+ *  
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of precomputed index permutations for
+ * every slice turn of a cube of a given size.
+ */
+
+#ifndef SLICE_TABLE_H
+#define SLICE_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "./move.h"
+
+/**
+ * Index permutations for slice turns, stored as 4-cycles. A clockwise quarter
+ * turn carries the element at the first index of each cycle to the second,
+ * the second to the third, the third to the fourth and the fourth to the
+ * first. Counterclockwise and half turns walk the same cycles backwards or
+ * two steps at a time, so one table serves every direction of a slice.
+ */
+class SliceTable {
+  public:
+    /**
+     * Get the shared table for a cube size, building it on first use. Safe
+     * to call from multiple threads.
+     *
+     * @param size Number of blocks along each edge of the cube.
+     * @return The table.
+     */
+    static const SliceTable& ForSize(int size);
+
+    /**
+     * Constructor for the table of a cube size.
+     *
+     * @param size Number of blocks along each edge of the cube.
+     */
+    explicit SliceTable(int size);
+
+    /**
+     * Turn the facelets of a cube, laid out as in CubeState. Every facelet
+     *    afterwards holds the element previously at the facelet it came from.
+     *
+     * @param facelets The facelets, or any array indexed like them.
+     * @param move The move.
+     */
+    template <typename T>
+    inline void TurnFacelets(T* facelets, const Move& move) const {
+      size_t slab = move.axis * m_size + move.slice;
+      ApplyCycles(facelets, &m_faceletCycles[m_faceletStart[slab]],
+                  m_faceletStart[slab + 1] - m_faceletStart[slab],
+                  move.turns);
+    }
+
+    /**
+     * Turn the blocks of a cube, stored at index (x * size + y) * size + z.
+     *
+     * @param blocks The blocks.
+     * @param move The move.
+     */
+    template <typename T>
+    inline void TurnBlocks(T* blocks, const Move& move) const {
+      ApplyCycles(blocks + move.slice * m_blockStride[move.axis],
+                  &m_blockCycles[m_blockStart[move.axis]],
+                  m_blockStart[move.axis + 1] - m_blockStart[move.axis],
+                  move.turns);
+    }
+
+    /**
+     * Turn the blocks on the surface of a cube, stored at SurfaceIndex().
+     *    Only the ring of blocks around an inner slab is on the surface, so
+     *    an inner slice turn moves O(size) blocks and an outer one O(size^2).
+     *
+     * @param blocks The surface blocks.
+     * @param move The move.
+     */
+    template <typename T>
+    inline void TurnSurfaceBlocks(T* blocks, const Move& move) const {
+      size_t slab = move.axis * m_size + move.slice;
+      ApplyCycles(blocks, &m_surfaceCycles[m_surfaceStart[slab]],
+                  m_surfaceStart[slab + 1] - m_surfaceStart[slab],
+                  move.turns);
+    }
+
+    /**
+     * Check whether a block is on the surface of a cube.
+     *
+     * @param x Position of the block along the x-axis.
+     * @param y Position of the block along the y-axis.
+     * @param z Position of the block along the z-axis.
+     * @return True if the block is on the surface, false if it is inside the
+     *    cube or off it.
+     */
+    inline bool OnSurface(int x, int y, int z) const {
+      int last = m_size - 1;
+      if (x < 0 || x > last || y < 0 || y > last || z < 0 || z > last) {
+        return false;
+      }
+      return x == 0 || x == last || y == 0 || y == last ||
+             z == 0 || z == last;
+    }
+
+    /**
+     * Get the index of a block on the surface of a cube. Surface blocks are
+     *    ordered by x, then y, then z: each outer x slab holds size * size
+     *    blocks, and each inner x slab only the 4 * (size - 1) blocks of its
+     *    ring.
+     *
+     * @param x Position of the block along the x-axis.
+     * @param y Position of the block along the y-axis.
+     * @param z Position of the block along the z-axis.
+     * @return The index of the block, which must be on the surface.
+     */
+    inline uint32_t SurfaceIndex(int x, int y, int z) const {
+      int last = m_size - 1;
+      uint32_t faceSize = m_size * m_size;
+      uint32_t ringSize = 4 * last;
+      if (x == 0) {
+        return y * m_size + z;
+      } else if (x == last) {
+        return faceSize + (last - 1) * ringSize + y * m_size + z;
+      }
+
+      uint32_t ring = faceSize + (x - 1) * ringSize;
+      if (y == 0) {
+        return ring + z;
+      } else if (y == last) {
+        return ring + m_size + z;
+      }
+      return ring + 2 * m_size + (y - 1) * 2 + (z == last ? 1 : 0);
+    }
+
+    /**
+     * Get the number of blocks on the surface of a cube.
+     *
+     * @return size^3 - (size - 2)^3, or 1 for a cube of size 1.
+     */
+    inline uint32_t NumSurfaceBlocks() const {
+      return (m_size == 1) ? 1 : 2 * m_size * m_size +
+                                 (m_size - 2) * 4 * (m_size - 1);
+    }
+
+    /**
+     * Get the size of cube a table was built for.
+     *
+     * @return Number of blocks along each edge of the cube.
+     */
+    inline int GetSize() const { return m_size; }
+  protected:
+  private:
+    /**
+     * Walk a run of 4-cycles a number of quarter turns.
+     *
+     * @param data The array to permute.
+     * @param cycles Four indices per cycle.
+     * @param numIndices Number of indices in the run, four per cycle.
+     * @param turns Number of clockwise quarter turns, 0 to 3.
+     */
+    template <typename T>
+    static inline void ApplyCycles(T* data, const uint32_t* cycles,
+                                   size_t numIndices, int turns) {
+      const uint32_t* end = cycles + numIndices;
+      T t;
+      switch (turns & 3) {
+        case 1:
+          for (const uint32_t* c = cycles; c != end; c += 4) {
+            t = data[c[3]];
+            data[c[3]] = data[c[2]];
+            data[c[2]] = data[c[1]];
+            data[c[1]] = data[c[0]];
+            data[c[0]] = t;
+          }
+          break;
+        case 2:
+          for (const uint32_t* c = cycles; c != end; c += 4) {
+            t = data[c[0]];  data[c[0]] = data[c[2]];  data[c[2]] = t;
+            t = data[c[1]];  data[c[1]] = data[c[3]];  data[c[3]] = t;
+          }
+          break;
+        case 3:
+          for (const uint32_t* c = cycles; c != end; c += 4) {
+            t = data[c[0]];
+            data[c[0]] = data[c[1]];
+            data[c[1]] = data[c[2]];
+            data[c[2]] = data[c[3]];
+            data[c[3]] = t;
+          }
+          break;
+      }
+    }
+
+    /**
+     * Get the index of the facelet of a block facing a given direction.
+     *
+     * @param axis Axis of the facelet normal.
+     * @param positive True if the facelet faces the positive direction.
+     * @param cell Position of the block along each axis.
+     * @return The index of the facelet.
+     */
+    uint32_t FaceletIndex(int axis, bool positive, const int cell[3]) const;
+
+    /**
+     * Get the surface index of a block, given as a position along each axis.
+     *
+     * @param cell Position of the block along each axis.
+     * @return The index of the block.
+     */
+    inline uint32_t SurfaceIndex(const int cell[3]) const {
+      return SurfaceIndex(cell[X], cell[Y], cell[Z]);
+    }
+
+    int m_size;
+
+    // Facelet cycles of slab (axis * size + slice) occupy indices
+    // m_faceletStart[slab] to m_faceletStart[slab + 1] of m_faceletCycles.
+    std::vector<uint32_t> m_faceletCycles;
+    std::vector<size_t> m_faceletStart;
+
+    // Block cycles within slice 0 of each axis; other slices are offset by a
+    // multiple of the stride of the axis.
+    std::vector<uint32_t> m_blockCycles;
+    size_t m_blockStart[4];
+    size_t m_blockStride[3];
+
+    // Surface block cycles of slab (axis * size + slice), laid out as the
+    // facelet cycles are.
+    std::vector<uint32_t> m_surfaceCycles;
+    std::vector<size_t> m_surfaceStart;
+};
+
+#endif  // SLICE_TABLE_H
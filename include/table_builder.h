@@ -0,0 +1,113 @@
+/**
+ * @file table_builder.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of a multi-threaded builder of solver
+ * pruning tables, which caches the tables it builds in pattern database
+ * files.
+ */
+
+#ifndef TABLE_BUILDER_H
+#define TABLE_BUILDER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "./pattern_database.h"
+
+/**
+ * A state space searched to build a pruning table. Every move must have its
+ * inverse among the moves, so that the search may run in either direction.
+ */
+class PruneSpace {
+  public:
+    static const int MAX_NEIGHBORS = 18;
+
+    virtual ~PruneSpace() {}
+
+    /**
+     * Get the number of states, each of which is a table entry.
+     *
+     * @return The number of states.
+     */
+    virtual uint64_t GetSize() const = 0;
+
+    /**
+     * Get the solved state, at distance zero.
+     *
+     * @return The index of the state.
+     */
+    virtual uint64_t GetGoal() const = 0;
+
+    /**
+     * Get the states one move away from a state.
+     *
+     * @param index The index of the state.
+     * @param neighbors The indices of the neighboring states (to be set).
+     * @return The number of neighbors, at most MAX_NEIGHBORS.
+     */
+    virtual int GetNeighbors(uint64_t index, uint64_t* neighbors) const = 0;
+};
+
+class TableBuilder {
+  public:
+    /**
+     * Constructor for a builder.
+     *
+     * @param numThreads Number of threads to search with, or 0 for one per
+     *    core.
+     * @param report True to print the time taken by each layer of the search
+     *    to standard error, leaving standard output to the caller.
+     */
+    explicit TableBuilder(int numThreads = 0, bool report = true);
+
+    /**
+     * Build a table by breadth-first search from the solved state. Each layer
+     * is split among the threads, which claim entries with atomic updates.
+     * Layers with a small frontier expand it; layers with a large frontier
+     * instead check each unreached state for a neighbor in the frontier.
+     *
+     * @param space The state space.
+     * @param table The entries, packed as in PatternDatabase (to be set).
+     */
+    void Build(const PruneSpace& space, std::vector<uint8_t>& table) const;
+
+    /**
+     * Map a table from its cache file, or build it and write the file if the
+     * file is missing, of another version or corrupt. If the file cannot be
+     * written the table is kept in memory instead.
+     *
+     * @param space The state space.
+     * @param path Path of the cache file.
+     * @param pattern Identifies the table within its file.
+     * @param database The table (to be set).
+     * @param verify True to check the file's checksum before using it.
+     */
+    void LoadOrBuild(const PruneSpace& space, const std::string& path,
+                     uint32_t pattern, PatternDatabase& database,
+                     bool verify = true) const;
+  protected:
+  private:
+    /**
+     * Search one layer of a table on a single thread.
+     *
+     * @param space The state space.
+     * @param table The packed entries.
+     * @param depth Distance of the frontier.
+     * @param backward True to search from unreached states to the frontier.
+     * @param nextChunk The first unclaimed chunk of entries.
+     * @param reached Number of entries reached (to be set).
+     */
+    static void SearchLayer(const PruneSpace* space, uint8_t* table,
+                            int depth, bool backward,
+                            std::atomic<uint64_t>* nextChunk,
+                            uint64_t* reached);
+
+    int m_numThreads;
+    bool m_report;
+};
+
+#endif  // TABLE_BUILDER_H
@@ -17,20 +17,28 @@ class Texture {
   public:
     /**
      * Constructor for a texture object, to contain be used for all textures
-     *    for a program.
+     *    for a program. Every texture is loaded as a layer of a single
+     *    texture array, to be selected by layer index within a shader, and
+     *    mipmaps are generated once all layers are loaded.
      *
      * @param numTextures Number of textures to load.
-     * @param fileNames Texture files.
+     * @param fileNames Texture files, which must share the same dimensions.
      */
     Texture(int numTextures, const std::string fileNames[]);
 
     /**
-     * Activate a desired texture.
+     * Activate the texture array.
      *
      * @param unit Texture unit to be used.
-     * @param texture Texture index.
      */
-    void Bind(unsigned int unit, int texture);
+    void Bind(unsigned int unit);
+
+    /**
+     * Get the number of layers of the texture array.
+     *
+     * @return The number of layers.
+     */
+    inline int GetNumTextures() const { return m_numTextures; }
 
     /**
      * Texture desctructor. Unload texture from graphics card via OpenGL.
@@ -39,7 +47,7 @@ class Texture {
   protected:
   private:
     GLsizei m_numTextures;
-    GLuint* m_textures;
+    GLuint m_texture;
 };
 
 #endif  // TEXTURE_H
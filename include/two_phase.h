@@ -0,0 +1,138 @@
+/**
+ * @file two_phase.h
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the declerations of Kociemba's two-phase solver for the
+ * 3x3 cube. Phase one reaches the subgroup generated by U, D, R2, F2, L2 and
+ * B2, in which every piece is oriented and the slice edges are in the slice.
+ * Phase two solves the cube within that subgroup.
+ */
+
+#ifndef TWO_PHASE_H
+#define TWO_PHASE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "./cube3.h"
+#include "./cubie_cube.h"
+#include "./pattern_database.h"
+
+class TwoPhaseSolver {
+  public:
+    /**
+     * Get the solver, building its move tables and loading its pruning
+     * tables from "./data/table" on first use. The solver may then be used
+     * from any number of threads.
+     *
+     * @return The solver.
+     */
+    static const TwoPhaseSolver& Get();
+
+    /**
+     * Constructor which builds the move tables, and loads the pruning tables
+     * from a directory, building and writing any which are missing.
+     *
+     * @param directory Directory holding the pruning table files.
+     */
+    explicit TwoPhaseSolver(const std::string& directory);
+
+    /**
+     * Find a solution for a cube.
+     *
+     * @param state The cube, of size 3.
+     * @param solution The face turns solving the cube (to be set).
+     * @param maxLength Stop at the first solution at most this long.
+     * @param timeoutMs Otherwise stop after this many milliseconds with the
+     *    shortest solution found so far, or 0 for no time limit.
+     * @param maxNodes Likewise stop after searching this many phase one
+     *    nodes, or 0 for no limit. Unlike a timeout, this gives the same
+     *    solution for a cube however loaded the machine is.
+     * @return True if a solution was found, false if the cube is unsolvable
+     *    or the search stopped before finding any solution.
+     */
+    bool Solve(const CubeState& state, std::vector<FaceTurn>& solution,
+               int maxLength = 20, int timeoutMs = 1000,
+               uint64_t maxNodes = 0) const;
+    bool Solve(const Cube3& cube, std::vector<FaceTurn>& solution,
+               int maxLength = 20, int timeoutMs = 1000,
+               uint64_t maxNodes = 0) const;
+    bool Solve(const CubieCube& cube, std::vector<FaceTurn>& solution,
+               int maxLength = 20, int timeoutMs = 1000,
+               uint64_t maxNodes = 0) const;
+  protected:
+  private:
+    struct Search;
+    class PairSpace;
+
+    /**
+     * Build the table of a coordinate under each move.
+     *
+     * @param table The table, size * numMoves entries (to be set).
+     * @param size Number of values of the coordinate.
+     * @param moves The face turns.
+     * @param numMoves Number of face turns.
+     * @param set Function setting the coordinate on a cube.
+     * @param get Function getting the coordinate from a cube.
+     */
+    static void BuildMoveTable(std::vector<uint16_t>& table, int size,
+                               const FaceTurn* moves, int numMoves,
+                               void (CubieCube::*set)(int),
+                               int (CubieCube::*get)() const);
+
+    /**
+     * Search for phase one solutions of a given length, then for each
+     * continue with phase two.
+     *
+     * @param search Search state.
+     * @param twist Corner orientation coordinate.
+     * @param flip Edge orientation coordinate.
+     * @param slice Slice edge position coordinate.
+     * @param depth Number of moves made so far.
+     * @param togo Number of moves left in phase one.
+     * @return True if the search is finished.
+     */
+    bool Phase1(Search& search, int twist, int flip, int slice, int depth,
+                int togo) const;
+
+    /**
+     * Search for a phase two solution following a phase one solution.
+     *
+     * @param search Search state.
+     * @param depth1 Length of the phase one solution.
+     * @return True if the search is finished.
+     */
+    bool StartPhase2(Search& search, int depth1) const;
+
+    /**
+     * Search for phase two solutions of a given length.
+     *
+     * @param search Search state.
+     * @param corner Corner permutation coordinate.
+     * @param edge U and D edge permutation coordinate.
+     * @param slice Slice edge permutation coordinate.
+     * @param depth Number of moves made so far.
+     * @param togo Number of moves left in phase two.
+     * @return True if a solution was found.
+     */
+    bool Phase2(Search& search, int corner, int edge, int slice, int depth,
+                int togo) const;
+
+    // Move tables, indexed by coordinate * number of moves + move.
+    std::vector<uint16_t> m_twistMove;      // All 18 face turns.
+    std::vector<uint16_t> m_flipMove;
+    std::vector<uint16_t> m_sliceMove;
+    std::vector<uint16_t> m_cornerMove;     // The 10 phase two turns.
+    std::vector<uint16_t> m_edge8Move;
+    std::vector<uint16_t> m_slicePermMove;
+
+    // Pruning tables, indexed by first coordinate * size of second + second.
+    PatternDatabase m_twistSlicePrune;
+    PatternDatabase m_flipSlicePrune;
+    PatternDatabase m_cornerSlicePrune;
+    PatternDatabase m_edgeSlicePrune;
+};
+
+#endif  // TWO_PHASE_H
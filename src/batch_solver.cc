@@ -0,0 +1,249 @@
+/**
+ * @file batch_solver.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a batch solver for 3x3 cubes.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include "../include/batch_solver.h"
+#include "../include/notation.h"
+
+// Face letters in the order of the FaceTurn values.
+static const char TURN_FACES[] = "URFDLB";
+
+// Facelet letters in the order of the Face values, as CubeState writes them.
+static const char FACELET_COLORS[] = "LRDUBF";
+
+// Phase one nodes the two-phase solver may search for each cube, in place of
+// a timeout, so that the solutions written depend only on the input. A few
+// seconds of search; almost every cube reaches 20 moves in far fewer.
+static const uint64_t TWO_PHASE_NODE_BUDGET = 1 << 24;
+
+BatchSolver::BatchSolver(const TwoPhaseSolver& solver, int numThreads,
+                         size_t bufferSize) {
+  m_twoPhase = &solver;
+  m_optimal = NULL;
+  m_numThreads = numThreads;
+  if (m_numThreads <= 0) {
+    m_numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_bufferSize = std::max(bufferSize, static_cast<size_t>(1));
+}
+
+BatchSolver::BatchSolver(const OptimalSolver& solver, int numThreads,
+                         size_t bufferSize) {
+  m_twoPhase = NULL;
+  m_optimal = &solver;
+  m_numThreads = numThreads;
+  if (m_numThreads <= 0) {
+    m_numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_bufferSize = std::max(bufferSize, static_cast<size_t>(1));
+}
+
+bool BatchSolver::Run(std::istream& input, std::ostream& output,
+                      std::ostream& report) {
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  m_jobs.clear();
+  m_results.assign(m_bufferSize, Result());
+  m_numRead = 0;
+  m_numWritten = 0;
+  m_inputDone = false;
+  m_latencies.clear();
+  m_numFailed = 0;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < m_numThreads; t++) {
+    threads.push_back(std::thread(&BatchSolver::SolveJobs, this));
+  }
+  std::thread writer(&BatchSolver::WriteResults, this, &output);
+
+  // Read on this thread, never more than the reorder buffer holds ahead of
+  // the writer, so memory stays bounded however long the input.
+  std::string line;
+  while (std::getline(input, line)) {
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    Job job;
+    ParseCube(line, job.cube, job.error);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_numRead >= m_numWritten + m_bufferSize) {
+      m_slotFreed.wait(lock);
+    }
+    job.sequence = m_numRead++;
+    m_jobs.push_back(job);
+    m_jobAdded.notify_one();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_inputDone = true;
+  }
+  m_jobAdded.notify_all();
+  m_resultReady.notify_all();
+
+  for (size_t t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+  writer.join();
+  output.flush();
+
+  double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  report << m_numWritten << " cubes in " << std::fixed
+         << std::setprecision(3) << seconds << " s on " << m_numThreads
+         << " threads, " << std::setprecision(1) << m_numWritten / seconds
+         << " solves/s";
+  if (m_numFailed > 0) {
+    report << ", " << m_numFailed << " failed";
+  }
+  report << std::endl;
+  if (!m_latencies.empty()) {
+    std::vector<double> sorted(m_latencies);
+    std::sort(sorted.begin(), sorted.end());
+    double p50 = sorted[(sorted.size() - 1) / 2];
+    double p99 = sorted[(sorted.size() - 1) * 99 / 100];
+    report << "latency p50 " << std::setprecision(3) << p50 * 1000.0
+           << " ms, p99 " << p99 * 1000.0 << " ms, max "
+           << sorted.back() * 1000.0 << " ms" << std::endl;
+  }
+  return m_numFailed == 0;
+}
+
+void BatchSolver::SolveJobs() {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (m_jobs.empty() && !m_inputDone) {
+        m_jobAdded.wait(lock);
+      }
+      if (m_jobs.empty()) {
+        break;
+      }
+      job = m_jobs.front();
+      m_jobs.pop_front();
+    }
+
+    Result result;
+    result.ready = true;
+    result.solved = false;
+    result.seconds = 0.0;
+    if (!job.error.empty()) {
+      result.text = "ERROR " + job.error;
+    } else {
+      std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+      std::vector<FaceTurn> solution;
+      if (m_optimal != NULL) {
+        result.solved = m_optimal->Solve(job.cube, solution);
+      } else {
+        result.solved = m_twoPhase->Solve(job.cube, solution, 20, 0,
+                                          TWO_PHASE_NODE_BUDGET);
+      }
+      result.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+      result.text = result.solved ? FormatTurns(solution)
+                                  : "ERROR no solution found";
+    }
+
+    // The reader keeps every unwritten cube within the buffer, so the slot
+    // is free.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_results[job.sequence % m_bufferSize] = result;
+    if (job.sequence == m_numWritten) {
+      m_resultReady.notify_one();
+    }
+  }
+}
+
+void BatchSolver::WriteResults(std::ostream* output) {
+  for (;;) {
+    Result result;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      Result* next = &m_results[m_numWritten % m_bufferSize];
+      while (!next->ready && !(m_inputDone && m_numWritten == m_numRead)) {
+        m_resultReady.wait(lock);
+      }
+      if (!next->ready) {
+        break;
+      }
+      result.text.swap(next->text);
+      result.solved = next->solved;
+      result.seconds = next->seconds;
+      next->ready = false;
+      m_numWritten++;
+      m_slotFreed.notify_one();
+    }
+
+    *output << result.text << '\n';
+    if (result.solved) {
+      m_latencies.push_back(result.seconds);
+    } else {
+      m_numFailed++;
+    }
+  }
+}
+
+bool BatchSolver::ParseCube(const std::string& line, CubieCube& cube,
+                            std::string& error) {
+  cube = CubieCube();
+  std::istringstream tokens(line);
+  std::string token;
+
+  // A single 54 letter token of facelet colors.
+  if (line.find_first_not_of(std::string(FACELET_COLORS) + " \t\r") ==
+        std::string::npos &&
+      (tokens >> token) && token.size() == Cube3::NUM_FACELETS) {
+    Cube3 facelets;
+    for (int i = 0; i < Cube3::NUM_FACELETS; i++) {
+      facelets.facelets[i] = std::string(FACELET_COLORS).find(token[i]);
+    }
+    if (!CubieCube::FromFacelets(facelets, cube)) {
+      error = "unsolvable cube";
+      return false;
+    }
+    return true;
+  }
+
+  // Otherwise face turns, such as "R U2 F'". The solvers keep the centers
+  // fixed, so inner slice turns and rotations are refused.
+  std::vector<Move> moves;
+  if (!Notation(3).Parse(line, moves, error)) {
+    return false;
+  }
+  for (size_t i = 0; i < moves.size(); i++) {
+    FaceTurn turn;
+    if (!MoveFaceTurn(moves[i], 3, turn)) {
+      error = "only face turns can be solved";
+      return false;
+    }
+    cube.Multiply(CubieCube::Turn(turn));
+  }
+  return true;
+}
+
+std::string BatchSolver::FormatTurns(const std::vector<FaceTurn>& turns) {
+  static const char* powers[3] = { "", "2", "'" };
+
+  std::string text;
+  for (size_t i = 0; i < turns.size(); i++) {
+    if (i > 0) {
+      text += ' ';
+    }
+    text += TURN_FACES[turns[i] / 3];
+    text += powers[turns[i] % 3];
+  }
+  return text;
+}
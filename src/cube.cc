@@ -8,27 +8,71 @@
  * Rubik's cube.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include "../include/cube.h"
 
-#define ROTATION_FRAMES 60
-
-Cube::Cube(int size) :
-  blocks(size, std::vector<std::vector<Block*> >
-      (size, std::vector<Block*>(size))) {
+Cube::Cube(int size, bool instanced, bool procedural, bool faceTextures) :
+  m_state(size),
+  m_sliceTable(&SliceTable::ForSize(size)) {
   this->size = size;
+  this->m_numSurface = 0;
+  this->m_numBlocks = 0;
   this->currRotateAxis = X;
-  this->currRotateN = 0;
-  this->currRotateClockwise = true;
   this->currRotateSteps = 0;
+  this->currRotateTicks = 0;
+  this->m_sliceTurns.assign(size, 0);
+  this->m_slabRotation[0] = glm::mat4();
+  this->m_slabRotation[1] = glm::mat4();
+  this->m_rotationTicks = TICKS_PER_SECOND;
+  this->m_parallelTurns = false;
+  this->m_playback = ANIMATED;
+  this->m_droppedMoves = 0;
   this->selected = glm::vec3(-1, -1, -1);  // No cube selected
+  this->m_hovered = glm::vec3(-1, -1, -1);
+  this->m_instanced = instanced && !faceTextures;
+  this->m_instancesDirty = true;
+  this->m_procedural = procedural;
+  this->m_textures = NULL;
+  this->m_faceTextures = faceTextures;
+  this->m_faceTexture = NULL;
+  this->m_box = NULL;
+
+  // Default color scheme, matching the block textures.
+  m_palette[0] = glm::vec3(0.05f, 0.05f, 0.05f);
+  m_palette[FACE_L + 1] = glm::vec3(1.0f, 1.0f, 1.0f);    // White
+  m_palette[FACE_R + 1] = glm::vec3(1.0f, 0.85f, 0.0f);   // Yellow
+  m_palette[FACE_D + 1] = glm::vec3(1.0f, 0.5f, 0.0f);    // Orange
+  m_palette[FACE_U + 1] = glm::vec3(0.8f, 0.0f, 0.0f);    // Red
+  m_palette[FACE_B + 1] = glm::vec3(0.0f, 0.3f, 0.9f);    // Blue
+  m_palette[FACE_F + 1] = glm::vec3(0.0f, 0.65f, 0.2f);   // Green
+
+  // Cubes drawn from face textures keep no blocks at all, only the state.
+  if (m_faceTextures) {
+    m_faceTexture = new FaceTexture(m_state);
+    m_box = CreateBox();
+    return;
+  }
+
+  m_numSurface = m_sliceTable->NumSurfaceBlocks();
+  m_numBlocks = m_numSurface;
+  m_posX.resize(m_numSurface);
+  m_posY.resize(m_numSurface);
+  m_posZ.resize(m_numSurface);
+  m_orientation.resize(m_numSurface);
+  m_color.resize(m_numSurface);
+  m_faceColors.resize(m_numSurface);
+  m_scale.resize(m_numSurface, 1.0f);
 
   float posOffset = (static_cast<float>(size) - 1.0f) / 2.0f;
-  // Create blocks on cube.
-  for (int z = 0; z < size; z++) {
+  // Create blocks on cube. Interior blocks can never be seen, so only those
+  // on the surface are stored, and rows through the interior hold just their
+  // two end blocks.
+  for (int x = 0; x < size; x++) {
     for (int y = 0; y < size; y++) {
-      for (int x = 0; x < size; x++) {
+      bool interiorRow = x != 0 && x != size - 1 && y != 0 && y != size - 1;
+      for (int z = 0; z < size; z += interiorRow ? size - 1 : 1) {
         Col newBlockColor;
         if (x == 0 &&
             y != 0 && y != size - 1 &&
@@ -138,15 +182,29 @@ Cube::Cube(int size) :
           newBlockColor = BLK;
         }
 
-        blocks[x][y][z] = new Block(newBlockColor,
-                                    glm::vec3(2 * (x - posOffset),
-                                              2 * (y - posOffset),
-                                              2 * (z - posOffset)),
-                                    glm::vec3(0, 0, 0));
+        int i = Cell(x, y, z);
+        m_color[i] = newBlockColor;
+        m_posX[i] = 2 * (x - posOffset);
+        m_posY[i] = 2 * (y - posOffset);
+        m_posZ[i] = 2 * (z - posOffset);
+
+        // Each face on the outside of the cube carries the sticker color of
+        // that face.
+        int cell[3] = { x, y, z };
+        for (int face = 0; face < NUM_FACES; face++) {
+          int outside = (face % 2 == 0) ? 0 : size - 1;
+          m_faceColors[i].face[face] =
+            (cell[face / 2] == outside) ? face + 1 : 0;
+        }
       }
     }
   }
 
+  // Procedurally shaded cubes need no textures.
+  if (m_procedural) {
+    return;
+  }
+
   // Load textures
   std::string fileNames[NUM_COLORS] = {
     "BLK",
@@ -185,13 +243,20 @@ Cube::Cube(int size) :
   m_textures = new Texture(NUM_COLORS, fileNames);
 }
 
-void Cube::SetRotation(Dim axis, int n, bool clockwise) {
-  if (currRotateSteps == 0 && n >= 0 && n < size) {
-    currRotateAxis = axis;
-    currRotateN = n;
-    currRotateClockwise = clockwise;
-    currRotateSteps = ROTATION_FRAMES;
+bool Cube::SetRotation(Dim axis, int n, bool clockwise) {
+  if (n < 0 || n >= size) {
+    return false;
   }
+  if (m_queue.size() >= MAX_QUEUED_MOVES) {
+    m_droppedMoves++;
+    return false;
+  }
+  m_queue.push_back(Move(axis, n, clockwise ? 1 : 3));
+  // Turns which have not advanced yet can still be joined by this one.
+  if (currRotateSteps == 0 || currRotateSteps == currRotateTicks) {
+    StartQueuedTurns();
+  }
+  return true;
 }
 
 void Cube::SetRandRotation() {
@@ -201,177 +266,434 @@ void Cube::SetRandRotation() {
   SetRotation(axis, n, clockwise);
 }
 
-void Cube::UpdateRotation() {
-  if (currRotateSteps != 0) {
-    int x_min = 0, y_min = 0, z_min = 0;
-    int x_max = size, y_max = size, z_max = size;
+void Cube::StartQueuedTurns() {
+  if (m_queue.empty()) {
+    return;
+  }
+  if (m_playback == INSTANT) {
+    // Turns under way land first, so that moves apply in order.
+    if (m_turning.empty()) {
+      std::vector<Move> queued(m_queue.begin(), m_queue.end());
+      m_queue.clear();
+      LandMoves(&queued[0], queued.size());
+    }
+    return;
+  }
 
-    // Choose correct blocks to rotate.
-    switch (currRotateAxis) {
-      case X: {
-        x_min = currRotateN;
-        x_max = currRotateN + 1;
-        break;
-      }
-      case Y: {
-        y_min = currRotateN;
-        y_max = currRotateN + 1;
-        break;
-      }
-      case Z: {
-        z_min = currRotateN;
-        z_max = currRotateN + 1;
-        break;
-      }
+  // Turbo playback shares out the time of one turn between the turn starting
+  // and those queued behind it, so a backlog of n turns drains in time
+  // growing with log(n) rather than n. Once a share is under one tick, the
+  // turns that would finish within the tick land at once, and only the last
+  // of them is animated.
+  if (m_playback == TURBO && m_turning.empty()) {
+    size_t perTick = (m_queue.size() + 1) / m_rotationTicks;
+    size_t numLanded = std::min(perTick, m_queue.size()) - 1;
+    if (perTick > 1 && numLanded > 0) {
+      std::vector<Move> landed(m_queue.begin(),
+                               m_queue.begin() + numLanded);
+      m_queue.erase(m_queue.begin(), m_queue.begin() + numLanded);
+      LandMoves(&landed[0], landed.size());
     }
+  }
 
-    // Rotate blocks.
-    for (int x = x_min; x < x_max; x++) {
-      for (int y = y_min; y < y_max; y++) {
-        for (int z = z_min; z < z_max; z++) {
+  // Take turns from the front of the queue for as long as they turn other
+  // slices about the same axis, so that they can share one animation.
+  size_t maxTurns = m_parallelTurns ? MAX_PARALLEL_TURNS : 1;
+  size_t numTurning = m_turning.size();
+  if (numTurning == 0) {
+    currRotateAxis = static_cast<Dim>(m_queue.front().axis);
+  }
+  while (!m_queue.empty() && m_turning.size() < maxTurns) {
+    const Move& move = m_queue.front();
+    if (move.axis != currRotateAxis || m_sliceTurns[move.slice] != 0) {
+      break;
+    }
+    m_sliceTurns[move.slice] = (move.turns == 1) ? 1 : -1;
+    m_turning.push_back(move);
+    m_queue.pop_front();
+  }
+  if (m_turning.size() == numTurning) {
+    return;
+  }
 
-          // Determine angle of rotation.
-          float deltaRot = (PI / 2) / ROTATION_FRAMES;
-          if (!currRotateClockwise) {
-            deltaRot *= -1.0f;
-          }
+  int ticks = m_rotationTicks;
+  if (m_playback == TURBO) {
+    ticks = std::max(1, static_cast<int>(
+      round(static_cast<float>(ticks) / (m_queue.size() + 1))));
+  }
+  currRotateSteps = ticks;
+  currRotateTicks = ticks;
+  m_slabRotation[0] = glm::mat4();
+  m_slabRotation[1] = glm::mat4();
+  UpdateSlab();
+  m_instancesDirty = true;
+}
 
-          // Choose position values to be modified and update rotation.
-          float* adj;
-          float* opp;
-          bool center;
-          int middleIndex = (size - 1) / 2;
-          switch (currRotateAxis) {
-            case X: {
-              blocks[x][y][z]->RotX(deltaRot);
-              adj = &blocks[x][y][z]->GetPos().y;
-              opp = &blocks[x][y][z]->GetPos().z;
-              center = (size % 2 == 1 && y ==  middleIndex && z == middleIndex);
-              break;
-            }
-            case Y: {
-              blocks[x][y][z]->RotY(deltaRot);
-              adj = &blocks[x][y][z]->GetPos().z;
-              opp = &blocks[x][y][z]->GetPos().x;
-              center = (size % 2 == 1 && x ==  middleIndex && z == middleIndex);
-              break;
-            }
-            case Z: {
-              blocks[x][y][z]->RotZ(deltaRot);
-              adj = &blocks[x][y][z]->GetPos().x;
-              opp = &blocks[x][y][z]->GetPos().y;
-              center = (size % 2 == 1 && x ==  middleIndex && y == middleIndex);
-              break;
-            }
-          }
+bool Cube::ApplyMoves(const Move* moves, size_t numMoves) {
+  for (size_t i = 0; i < numMoves; i++) {
+    if (moves[i].axis > Z || moves[i].slice >= size) {
+      return false;
+    }
+  }
 
-          // Update relevant position values.
-          if (!center) {
-            float hyp = sqrt(pow(*adj, 2) + pow(*opp, 2));
-            if (*adj < 0) {
-              hyp = hyp * -1.0f;
-            }
-            float theta1 = atan(*opp / *adj);
-            *adj = hyp * cos(theta1 + deltaRot);
-            *opp = hyp * sin(theta1 + deltaRot);
-          }
-        }
+  // Turns made earlier land first, so that moves apply in order.
+  if (!m_turning.empty()) {
+    std::vector<Move> turning;
+    turning.swap(m_turning);
+    for (size_t k = 0; k < turning.size(); k++) {
+      m_sliceTurns[turning[k].slice] = 0;
+    }
+    currRotateSteps = 0;
+    LandMoves(&turning[0], turning.size());
+  }
+  if (!m_queue.empty()) {
+    std::vector<Move> queued(m_queue.begin(), m_queue.end());
+    m_queue.clear();
+    LandMoves(&queued[0], queued.size());
+  }
+  if (numMoves > 0) {
+    LandMoves(moves, numMoves);
+  }
+  return true;
+}
+
+void Cube::LandMoves(const Move* moves, size_t numMoves) {
+  m_state.Apply(moves, numMoves);
+  m_state.Flush();
+  if (m_faceTextures) {
+    // One upload of the faces covers the whole sequence.
+    m_faceTexture->Update(m_state);
+  } else {
+    // Only the runs of surface blocks in each slab are turned, with no
+    // exposed interior and no animation.
+    for (size_t i = 0; i < numMoves; i++) {
+      const Move& move = moves[i];
+      if (move.turns == 0) {
+        continue;
       }
+      currRotateAxis = static_cast<Dim>(move.axis);
+      m_slabRuns.clear();
+      AddSlabRuns(move.slice);
+      bool clockwise = move.turns != 3;
+      QuarterTurnRuns(0, m_slabRuns.size(), clockwise);
+      if (move.turns == 2) {
+        QuarterTurnRuns(0, m_slabRuns.size(), clockwise);
+      }
+      TurnBlockArrays(move);
     }
+  }
+  for (size_t i = 0; i < numMoves; i++) {
+    TurnSelected(moves[i]);
+  }
+
+  // The block arrays are uploaded once, on the next draw.
+  UpdateSlab();
+  m_instancesDirty = true;
+}
 
+void Cube::UpdateRotation() {
+  if (currRotateSteps != 0) {
     // Keep track of amount of rotation.
     currRotateSteps--;
 
+    // Blocks rest in their starting poses while their slabs turn. Their
+    // current poses follow from one rotation per direction of turn, so
+    // nothing accumulates from tick to tick.
+    m_slabRotation[0] = GetSlabRotation(0.0f, false);
+    m_slabRotation[1] = GetSlabRotation(0.0f, true);
+
     // Check rotation completion.
     if (currRotateSteps == 0) {
-      // Update block positions on cube.
-      int translate = size - 1;
-      // Aux pointer matrix.
-      std::vector< std::vector< std::vector <Block*> > > tempBlocks(size,
-        std::vector<std::vector<Block*> >(size, std::vector<Block*>(size)));
-      for (int x = x_min; x < x_max; x++) {
-        for (int y = y_min; y < y_max; y++) {
-          for (int z = z_min; z < z_max; z++) {
-            switch (currRotateAxis) {
-              case X: {
-                if (currRotateClockwise) {
-                  tempBlocks[x][y][z] = blocks[x][z][translate - y];
-                } else {
-                  tempBlocks[x][y][z] = blocks[x][translate - z][y];
-                }
-                break;
-              }
-              case Y: {
-                if (currRotateClockwise) {
-                  tempBlocks[x][y][z] = blocks[translate - z][y][x];
-                } else {
-                  tempBlocks[x][y][z] = blocks[z][y][translate - x];
-                }
-                break;
-              }
-              case Z: {
-                if (currRotateClockwise) {
-                  tempBlocks[x][y][z] = blocks[y][translate - x][z];
-                } else {
-                  tempBlocks[x][y][z] = blocks[translate - y][x][z];
-                }
-                break;
-              }
-            }
-          }
+      // Blocks land exactly on their new cells and orientations.
+      if (!m_faceTextures) {
+        for (size_t k = 0; k < m_turning.size(); k++) {
+          QuarterTurnRuns(m_slabRunStart[k], m_slabRunStart[k + 1],
+                          m_turning[k].turns == 1);
         }
       }
-      for (int x = x_min; x < x_max; x++) {
-        for (int y = y_min; y < y_max; y++) {
-          for (int z = z_min; z < z_max; z++) {
-            blocks[x][y][z] = tempBlocks[x][y][z];
-          }
+
+      for (size_t k = 0; k < m_turning.size(); k++) {
+        // Update block positions on cube.
+        const Move& move = m_turning[k];
+        m_state.Apply(move);
+        m_state.Flush();
+        if (m_faceTextures) {
+          m_faceTexture->Update(m_state, move);
+        } else {
+          TurnBlockArrays(move);
         }
+        TurnSelected(move);
+        m_sliceTurns[move.slice] = 0;
+      }
+      m_turning.clear();
+
+      // Start the next turns on the same tick, so queued turns play back to
+      // back.
+      if (m_queue.empty()) {
+        UpdateSlab();
+        m_instancesDirty = true;
+      } else {
+        StartQueuedTurns();
       }
+    }
+  }
+}
+
+void Cube::QuarterTurnRuns(size_t firstRun, size_t lastRun, bool clockwise) {
+  // Turning about an axis moves a block within the plane of the other two,
+  // and quarter turns of lattice positions are exact swaps and negations.
+  float* pos[3] = { &m_posX[0], &m_posY[0], &m_posZ[0] };
+  float* adj = pos[(currRotateAxis + 1) % 3];
+  float* opp = pos[(currRotateAxis + 2) % 3];
+  float s = clockwise ? 1.0f : -1.0f;
+  const OrientationGroup& group = OrientationGroup::Get();
+  for (size_t r = firstRun; r < lastRun; r++) {
+    int first = m_slabRuns[r].first;
+    int last = m_slabRuns[r].second;
+    // Every block is independent, so this loop vectorizes.
+    for (int i = first; i < last; i++) {
+      float a = adj[i];
+      adj[i] = -s * opp[i];
+      opp[i] = s * a;
+    }
+    for (int i = first; i < last; i++) {
+      m_orientation[i] = group.Turn(m_orientation[i], currRotateAxis,
+                                    clockwise);
+    }
+  }
+}
+
+void Cube::UpdateSlab() {
+  m_slabRuns.clear();
+  m_slabRunStart.assign(1, 0);
+  m_exposedLayers.clear();
+  m_numBlocks = m_numSurface;
+  if (m_turning.empty() || m_faceTextures) {
+    return;
+  }
+
+  // A turning slab uncovers its own interior, and the interior faces of the
+  // slabs to either side of it. Outer slabs have no interior. Interior
+  // blocks have no stickers.
+  for (int layer = 1; layer < size - 1; layer++) {
+    if (m_sliceTurns[layer - 1] != 0 || m_sliceTurns[layer] != 0 ||
+        m_sliceTurns[layer + 1] != 0) {
+      m_exposedLayers.push_back(layer);
+    }
+  }
+  int layerSize = (size - 2) * (size - 2);
+  m_numBlocks = m_numSurface + m_exposedLayers.size() * layerSize;
+  m_posX.resize(m_numBlocks);
+  m_posY.resize(m_numBlocks);
+  m_posZ.resize(m_numBlocks);
+  m_orientation.resize(m_numBlocks);
+  m_color.resize(m_numBlocks);
+  m_faceColors.resize(m_numBlocks);
+  m_scale.resize(m_numBlocks);
+
+  int u = (currRotateAxis + 1) % 3;
+  int v = (currRotateAxis + 2) % 3;
+  float posOffset = (size - 1.0f) / 2.0f;
+  int i = m_numSurface;
+  glm::ivec3 cell;
+  for (size_t l = 0; l < m_exposedLayers.size(); l++) {
+    cell[currRotateAxis] = m_exposedLayers[l];
+    for (cell[u] = 1; cell[u] < size - 1; cell[u]++) {
+      for (cell[v] = 1; cell[v] < size - 1; cell[v]++) {
+        m_posX[i] = 2.0f * (cell.x - posOffset);
+        m_posY[i] = 2.0f * (cell.y - posOffset);
+        m_posZ[i] = 2.0f * (cell.z - posOffset);
+        m_orientation[i] = 0;
+        m_color[i] = BLK;
+        m_faceColors[i] = FaceColors();
+        i++;
+      }
+    }
+  }
+
+  for (size_t k = 0; k < m_turning.size(); k++) {
+    int n = m_turning[k].slice;
+    AddSlabRuns(n);
+
+    // Its own interior, if it has one, is one run of the exposed blocks.
+    int first = ExposedIndex(n, 1, 1);
+    if (first >= 0) {
+      m_slabRuns.push_back(std::make_pair(first, first + layerSize));
+    }
+    m_slabRunStart.push_back(m_slabRuns.size());
+  }
+}
+
+void Cube::AddSlabRuns(int n) {
+  size_t slabFirst = m_slabRuns.size();
+
+  // Surface blocks of the slab, walked in memory order so that neighbors
+  // in the block arrays join into runs. Rows through the interior of the
+  // cube hold just their two end blocks.
+  int x_min = 0, y_min = 0, z_min = 0;
+  int x_max = size, y_max = size, z_max = size;
+  switch (currRotateAxis) {
+    case X: {
+      x_min = n;
+      x_max = n + 1;
+      break;
+    }
+    case Y: {
+      y_min = n;
+      y_max = n + 1;
+      break;
+    }
+    case Z: {
+      z_min = n;
+      z_max = n + 1;
+      break;
+    }
+  }
+  for (int x = x_min; x < x_max; x++) {
+    for (int y = y_min; y < y_max; y++) {
+      bool interiorRow = x > 0 && x < size - 1 && y > 0 && y < size - 1;
+      for (int z = z_min; z < z_max; z += interiorRow ? size - 1 : 1) {
+        if (!m_sliceTable->OnSurface(x, y, z)) {
+          continue;
+        }
+        int j = Cell(x, y, z);
+        if (m_slabRuns.size() > slabFirst &&
+            m_slabRuns.back().second == j) {
+          m_slabRuns.back().second++;
+        } else {
+          m_slabRuns.push_back(std::make_pair(j, j + 1));
+        }
+      }
+    }
+  }
+}
 
-      // Update selected block
-      switch (currRotateAxis) {
-        case X: {
-          if (selected.x == currRotateN) {
-            if (currRotateClockwise) {
-              selected =
-                glm::vec3(selected.x, translate - selected.z, selected.y);
-            } else {
-              selected =
-                glm::vec3(selected.x, selected.z, translate - selected.y);
-            }
+void Cube::TurnBlockArrays(const Move& move) {
+  m_sliceTable->TurnSurfaceBlocks(&m_posX[0], move);
+  m_sliceTable->TurnSurfaceBlocks(&m_posY[0], move);
+  m_sliceTable->TurnSurfaceBlocks(&m_posZ[0], move);
+  m_sliceTable->TurnSurfaceBlocks(&m_orientation[0], move);
+  m_sliceTable->TurnSurfaceBlocks(&m_color[0], move);
+  m_sliceTable->TurnSurfaceBlocks(&m_faceColors[0], move);
+}
+
+void Cube::TurnSelected(const Move& move) {
+  int translate = size - 1;
+  int n = move.slice;
+  bool clockwise = move.turns != 3;
+  int quarterTurns = clockwise ? move.turns : 1;
+  for (int q = 0; q < quarterTurns; q++) {
+    switch (move.axis) {
+      case X: {
+        if (selected.x == n) {
+          if (clockwise) {
+            selected =
+              glm::vec3(selected.x, translate - selected.z, selected.y);
+          } else {
+            selected =
+              glm::vec3(selected.x, selected.z, translate - selected.y);
           }
-          break;
         }
-        case Y: {
-          if (selected.y == currRotateN) {
-            if (currRotateClockwise) {
-              selected =
-                glm::vec3(selected.z, selected.y, translate - selected.x);
-            } else {
-              selected =
-                glm::vec3(translate - selected.z, selected.y, selected.x);
-            }
+        break;
+      }
+      case Y: {
+        if (selected.y == n) {
+          if (clockwise) {
+            selected =
+              glm::vec3(selected.z, selected.y, translate - selected.x);
+          } else {
+            selected =
+              glm::vec3(translate - selected.z, selected.y, selected.x);
           }
-          break;
         }
-        case Z: {
-          if (selected.z == currRotateN) {
-            if (currRotateClockwise) {
-              selected =
-                glm::vec3(translate - selected.y, selected.x, selected.z);
-            } else {
-              selected =
-                glm::vec3(selected.y, translate - selected.x, selected.z);
-            }
-          break;
+        break;
+      }
+      case Z: {
+        if (selected.z == n) {
+          if (clockwise) {
+            selected =
+              glm::vec3(translate - selected.y, selected.x, selected.z);
+          } else {
+            selected =
+              glm::vec3(selected.y, translate - selected.x, selected.z);
           }
         }
+        break;
       }
     }
   }
 }
 
+int Cube::ExposedIndex(int layer, int cu, int cv) const {
+  std::vector<int>::const_iterator found =
+    std::lower_bound(m_exposedLayers.begin(), m_exposedLayers.end(), layer);
+  if (found == m_exposedLayers.end() || *found != layer) {
+    return -1;
+  }
+  int inner = size - 2;
+  int l = found - m_exposedLayers.begin();
+  return m_numSurface + (l * inner + cu - 1) * inner + cv - 1;
+}
+
+int Cube::BlockIndex(const glm::vec3& cell) const {
+  glm::ivec3 c(cell);
+  if (m_sliceTable->OnSurface(c.x, c.y, c.z)) {
+    return Cell(c.x, c.y, c.z);
+  }
+  if (m_exposedLayers.empty() || c.x < 0) {
+    return -1;
+  }
+  return ExposedIndex(c[currRotateAxis], c[(currRotateAxis + 1) % 3],
+                      c[(currRotateAxis + 2) % 3]);
+}
+
+glm::vec3 Cube::GetPos(int x, int y, int z) const {
+  int i = Cell(x, y, z);
+  glm::vec3 pos(m_posX[i], m_posY[i], m_posZ[i]);
+  int cell[3] = { x, y, z };
+  int turn = SliceTurn(cell[currRotateAxis]);
+  if (turn != 0) {
+    pos = glm::vec3(m_slabRotation[turn > 0] * glm::vec4(pos, 1.0f));
+  }
+  return pos;
+}
+
+glm::mat4 Cube::GetRot(int x, int y, int z) const {
+  const glm::mat4& rest =
+    OrientationGroup::Get().Matrix(m_orientation[Cell(x, y, z)]);
+  int cell[3] = { x, y, z };
+  int turn = SliceTurn(cell[currRotateAxis]);
+  if (turn != 0) {
+    return m_slabRotation[turn > 0] * rest;
+  }
+  return rest;
+}
+
+void Cube::SetMovesPerSecond(float movesPerSecond) {
+  if (movesPerSecond > 0.0f) {
+    m_rotationTicks = std::max(1, static_cast<int>(
+      round(TICKS_PER_SECOND / movesPerSecond)));
+  }
+}
+
+float Cube::GetRotationAngle(float interpolation) const {
+  if (currRotateSteps == 0) {
+    return 0.0f;
+  }
+  // The pose one tick ahead is known exactly, so there is nothing to guess
+  // in drawing part way towards it.
+  float elapsed = std::min(currRotateTicks - currRotateSteps + interpolation,
+                           static_cast<float>(currRotateTicks));
+  return (PI / 2) * elapsed / currRotateTicks;
+}
+
+glm::mat4 Cube::GetSlabRotation(float interpolation, bool clockwise) const {
+  glm::vec3 axis(0.0f, 0.0f, 0.0f);
+  axis[currRotateAxis] = 1.0f;
+  float angle = GetRotationAngle(interpolation);
+  return glm::rotate(clockwise ? angle : -angle, axis);
+}
+
 void Cube::RotateXZ(Dim absZgreaterX, bool ZgreatX, bool XgreatZ,
               glm::vec3& forward) {
   Dim absXgreaterZ;
@@ -400,84 +722,305 @@ void Cube::RotateXZ(Dim absZgreaterX, bool ZgreatX, bool XgreatZ,
 }
 
 void Cube::Draw(Shader &shader, Transform &transform,
-                Camera &camera, Mesh &mesh) {
-  for (int z = 0; z < size; z++) {
-    for (int y = 0; y < size; y++) {
-      for (int x = 0; x < size; x++) {
-        shader.Bind();
+                Camera &camera, Mesh &mesh, float interpolation) {
+  glm::mat4 slabRotation[2] = {
+    GetSlabRotation(interpolation, false),
+    GetSlabRotation(interpolation, true)
+  };
+  if (m_faceTextures) {
+    DrawFaces(shader, transform, camera, slabRotation);
+    return;
+  }
 
-        m_textures->Bind(0, blocks[x][y][z]->GetCol());
+  if (m_instancesDirty) {
+    UpdateScales();
+    if (m_instanced) {
+      UpdateInstances(mesh);
+    }
+    m_instancesDirty = false;
+  }
 
-        transform.SetPos(this->GetPos(x, y, z));
-        transform.SetRot(this->GetRot(x, y, z));
+  if (m_instanced) {
+    // Only the slabs under rotation move, which the shader works out from
+    // the rotation axis, slab positions and current angles.
+    glm::vec3 sliceAxis(0.0f, 0.0f, 0.0f);
+    sliceAxis[currRotateAxis] = 1.0f;
+    float slicePos[MAX_PARALLEL_TURNS] = { 0.0f };
+    float sliceAngle[MAX_PARALLEL_TURNS] = { 0.0f };
+    float angle = GetRotationAngle(interpolation);
+    for (size_t k = 0; k < m_turning.size(); k++) {
+      slicePos[k] = 2.0f * (m_turning[k].slice - (size - 1.0f) / 2.0f);
+      sliceAngle[k] = (m_turning[k].turns == 1) ? angle : -angle;
+    }
 
-        if (this->GetSelected() == glm::vec3(x, y, z)) {
-          transform.SetScale(glm::vec3(1.2f, 1.2f, 1.2f));
-        } else {
-          transform.SetScale(glm::vec3(1.0f, 1.0f, 1.0f));
-        }
+    shader.Bind();
+    if (m_procedural) {
+      shader.UpdatePalette(m_palette, NUM_FACES + 1);
+    } else {
+      m_textures->Bind(0);
+    }
+    shader.Update(camera);
+    shader.UpdateOrientations(OrientationGroup::Get().Matrices(),
+                              OrientationGroup::NUM_ORIENTATIONS);
+    shader.UpdateSlices(sliceAxis, slicePos, sliceAngle, MAX_PARALLEL_TURNS);
+    mesh.DrawInstanced();
+    return;
+  }
 
-        shader.Update(transform, camera);
-        mesh.Draw();
-      }
+  // Every block samples its own layer of one texture array, so nothing is
+  // bound within the loop.
+  shader.Bind();
+  if (m_procedural) {
+    shader.UpdatePalette(m_palette, NUM_FACES + 1);
+  } else {
+    m_textures->Bind(0);
+  }
+
+  // Blocks of the turning slabs rest in their starting poses until the turn
+  // completes, so the rotation so far is applied on top of them.
+  const OrientationGroup& group = OrientationGroup::Get();
+  const float* restPos[3] = { &m_posX[0], &m_posY[0], &m_posZ[0] };
+  float posOffset = (size - 1.0f) / 2.0f;
+  for (int i = 0; i < m_numBlocks; i++) {
+    if (m_procedural) {
+      shader.UpdateFaceColors(m_faceColors[i].face);
+    } else {
+      shader.UpdateLayer(m_color[i]);
+    }
+
+    glm::vec3 pos(m_posX[i], m_posY[i], m_posZ[i]);
+    int slice = static_cast<int>(
+      floor(restPos[currRotateAxis][i] / 2.0f + posOffset + 0.5f));
+    int turn = SliceTurn(slice);
+    if (turn != 0) {
+      const glm::mat4& rot = slabRotation[turn > 0];
+      transform.SetPos(glm::vec3(rot * glm::vec4(pos, 1.0f)));
+      transform.SetRot(rot * group.Matrix(m_orientation[i]));
+    } else {
+      transform.SetPos(pos);
+      transform.SetRot(group.Matrix(m_orientation[i]));
     }
+    transform.SetScale(glm::vec3(m_scale[i], m_scale[i], m_scale[i]));
+
+    shader.Update(transform, camera);
+    mesh.Draw();
   }
 }
 
-void Cube::SelectBlock(const glm::vec3& rayStart, const glm::vec3& rayDir) {
-  // Small incrememnts for collision check.
-  glm::vec3 delta = rayDir / 100.0f;
+void Cube::DrawFaces(Shader& shader, Transform& transform, Camera& camera,
+                     const glm::mat4* slabRotation) {
+  shader.Bind();
+  m_faceTexture->Bind(0);
+  shader.UpdatePalette(m_palette, NUM_FACES + 1);
+  shader.UpdateHighlight(selected, m_hovered);
+  transform.SetPos(glm::vec3(0.0f, 0.0f, 0.0f));
+  transform.SetScale(glm::vec3(1.0f, 1.0f, 1.0f));
 
-  // Ray collision check.
-  glm::vec3 currPoint(rayStart);
-  bool found = false;
+  // Blocks are 2 units wide, so the cube spans -size to size on each axis.
+  glm::vec3 cubeMin(-size, -size, -size);
+  glm::vec3 cubeMax(size, size, size);
+  if (currRotateSteps == 0) {
+    DrawBox(shader, transform, camera, cubeMin, cubeMax, glm::mat4());
+    return;
+  }
 
-  int x = 0;
-  int y = 0;
-  int z = 0;
+  // Cut the cube into the turning slabs and the runs of resting slices
+  // between them, each a box sampling the same face textures.
+  glm::vec3 boxMin = cubeMin;
+  glm::vec3 boxMax = cubeMax;
+  int rest = 0;  // First slice of the current run of resting slices.
+  for (int n = 0; n <= size; n++) {
+    int turn = (n < size) ? m_sliceTurns[n] : 0;
+    if (n < size && turn == 0) {
+      continue;
+    }
+    if (n > rest) {
+      boxMin[currRotateAxis] = 2.0f * rest - size;
+      boxMax[currRotateAxis] = 2.0f * n - size;
+      DrawBox(shader, transform, camera, boxMin, boxMax, glm::mat4());
+    }
+    if (n < size) {
+      boxMin[currRotateAxis] = 2.0f * n - size;
+      boxMax[currRotateAxis] = 2.0f * n + 2.0f - size;
+      DrawBox(shader, transform, camera, boxMin, boxMax,
+              slabRotation[turn > 0]);
+    }
+    rest = n + 1;
+  }
+}
 
-  float halfSideLength = static_cast<float>(size);
+void Cube::DrawBox(Shader& shader, Transform& transform, Camera& camera,
+                   const glm::vec3& boxMin, const glm::vec3& boxMax,
+                   const glm::mat4& rot) {
+  transform.SetRot(rot);
+  shader.UpdateBox(boxMin, boxMax);
+  shader.Update(transform, camera);
+  m_box->Draw();
+}
 
-  // Get close to cube.
-  while (fabs(currPoint.x) > halfSideLength + 0.1f &&
-         fabs(currPoint.y) > halfSideLength + 0.1f &&
-         fabs(currPoint.z) > halfSideLength + 0.1f) {
-    currPoint += delta;
-  }
-
-  // Iterate over points on ray.
-  while (!found && (   fabs(currPoint.x) < halfSideLength + 0.2f
-                    || fabs(currPoint.y) < halfSideLength + 0.2f
-                    || fabs(currPoint.z) < halfSideLength + 0.2f)) {
-    currPoint += delta;
-
-    // Check point collision with any block.
-    for (x = 0; x < size && !found; x++) {
-      for (y = 0; y < size && !found; y++) {
-        for (z = 0; z < size && !found; z++) {
-            if ( fabs(GetPos(x, y, z).x - currPoint.x) < 1.0f
-              && fabs(GetPos(x, y, z).y - currPoint.y) < 1.0f
-              && fabs(GetPos(x, y, z).z - currPoint.z) < 1.0f) {
-            found = true;
-            GetSelected() = glm::vec3(x, y, z);
-          }
-        }
-      }
+Mesh* Cube::CreateBox() {
+  // Four corners of each face, with the face normal, wound
+  // counterclockwise when seen from outside.
+  std::vector<Vertex> vertices;
+  std::vector<unsigned int> indices;
+  for (int face = 0; face < NUM_FACES; face++) {
+    int axis = face / 2;
+    float sign = (face % 2 == 1) ? 1.0f : -1.0f;
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    glm::vec3 normal(0.0f, 0.0f, 0.0f);
+    normal[axis] = sign;
+
+    unsigned int first = vertices.size();
+    static const float corners[4][2] = {
+      { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f }
+    };
+    for (int i = 0; i < 4; i++) {
+      glm::vec3 pos = normal;
+      pos[u] = corners[i][0] * sign;
+      pos[v] = corners[i][1];
+      vertices.push_back(Vertex(pos, glm::vec2(0.0f, 0.0f), normal));
+    }
+    unsigned int quad[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int i = 0; i < 6; i++) {
+      indices.push_back(first + quad[i]);
     }
   }
+  return new Mesh(&vertices[0], vertices.size(), &indices[0], indices.size());
+}
 
-  if (!found) {
-    this->GetSelected() = glm::vec3(-1, -1, -1);
+void Cube::UpdateScales() {
+  std::fill(m_scale.begin(), m_scale.begin() + m_numBlocks, 1.0f);
+  int hoveredIndex = BlockIndex(m_hovered);
+  if (hoveredIndex >= 0) {
+    m_scale[hoveredIndex] = 1.1f;
+  }
+  int selectedIndex = BlockIndex(selected);
+  if (selectedIndex >= 0) {
+    m_scale[selectedIndex] = 1.2f;
   }
 }
 
-Cube::~Cube() {
-  for (int z = 0; z < size; z++) {
-    for (int y = 0; y < size; y++) {
-      for (int x = 0; x < size; x++) {
-        delete blocks[x][y][z];
+void Cube::UpdateInstances(Mesh& mesh) {
+  MeshInstances instances;
+  instances.posX = &m_posX[0];
+  instances.posY = &m_posY[0];
+  instances.posZ = &m_posZ[0];
+  instances.orientation = &m_orientation[0];
+  instances.texture = m_procedural ? NULL : &m_color[0];
+  instances.scale = &m_scale[0];
+  instances.faceColors = m_procedural ? m_faceColors[0].face : NULL;
+  instances.count = m_numBlocks;
+  mesh.SetInstances(instances);
+}
+
+void Cube::SelectBlock(const glm::vec3& rayStart, const glm::vec3& rayDir) {
+  if (!PickBlock(rayStart, rayDir, selected)) {
+    selected = glm::vec3(-1, -1, -1);
+  }
+  m_instancesDirty = true;
+}
+
+void Cube::HoverBlock(const glm::vec3& rayStart, const glm::vec3& rayDir) {
+  glm::vec3 hovered;
+  if (!PickBlock(rayStart, rayDir, hovered)) {
+    hovered = glm::vec3(-1, -1, -1);
+  }
+  if (hovered != m_hovered) {
+    m_hovered = hovered;
+    m_instancesDirty = true;
+  }
+}
+
+bool Cube::PickBlock(const glm::vec3& rayStart, const glm::vec3& rayDir,
+                     glm::vec3& cell) {
+  // Blocks are 2 units wide, so the cube spans -size to size on each axis.
+  float halfSideLength = static_cast<float>(size);
+
+  // Clip the ray to the cube's bounding box (slab test).
+  float tEnter = 0.0f;
+  float tExit = INFINITY;
+  for (int axis = 0; axis < 3; axis++) {
+    if (rayDir[axis] == 0.0f) {
+      if (fabs(rayStart[axis]) > halfSideLength) {
+        return false;
       }
+      continue;
+    }
+    float t0 = (-halfSideLength - rayStart[axis]) / rayDir[axis];
+    float t1 = (halfSideLength - rayStart[axis]) / rayDir[axis];
+    tEnter = std::max(tEnter, std::min(t0, t1));
+    tExit = std::min(tExit, std::max(t0, t1));
+  }
+  if (tEnter > tExit) {
+    return false;
+  }
+
+  // Walk the cells the ray passes through, in order (Amanatides and Woo),
+  // starting from the cell where it enters the cube.
+  int pos[3], step[3];
+  float tMax[3], tDelta[3];
+  for (int axis = 0; axis < 3; axis++) {
+    float entry = rayStart[axis] + tEnter * rayDir[axis];
+    pos[axis] = static_cast<int>(floor((entry + halfSideLength) / 2.0f));
+    pos[axis] = std::max(0, std::min(pos[axis], size - 1));
+    if (rayDir[axis] > 0.0f) {
+      step[axis] = 1;
+      tMax[axis] = (2.0f * (pos[axis] + 1) - halfSideLength -
+                    rayStart[axis]) / rayDir[axis];
+      tDelta[axis] = 2.0f / rayDir[axis];
+    } else if (rayDir[axis] < 0.0f) {
+      step[axis] = -1;
+      tMax[axis] = (2.0f * pos[axis] - halfSideLength - rayStart[axis]) /
+                   rayDir[axis];
+      tDelta[axis] = -2.0f / rayDir[axis];
+    } else {
+      step[axis] = 0;
+      tMax[axis] = INFINITY;
+      tDelta[axis] = INFINITY;
     }
   }
+
+  for (;;) {
+    // A block counts as hit while it is within its cell, which every block
+    // is except those of a slab part way through a rotation.
+    // Interior blocks, and every block of a cube drawn from face textures,
+    // are only ever out of their cells while their slab turns.
+    glm::vec3 center(2.0f * pos[0] - halfSideLength + 1.0f,
+                     2.0f * pos[1] - halfSideLength + 1.0f,
+                     2.0f * pos[2] - halfSideLength + 1.0f);
+    glm::vec3 blockPos = center;
+    if (m_numSurface != 0 &&
+        m_sliceTable->OnSurface(pos[0], pos[1], pos[2])) {
+      blockPos = GetPos(pos[0], pos[1], pos[2]);
+    } else if (SliceTurn(pos[currRotateAxis]) != 0) {
+      blockPos = glm::vec3(INFINITY, INFINITY, INFINITY);
+    }
+    if (fabs(blockPos.x - center.x) < 1.0f &&
+        fabs(blockPos.y - center.y) < 1.0f &&
+        fabs(blockPos.z - center.z) < 1.0f) {
+      cell = glm::vec3(pos[0], pos[1], pos[2]);
+      return true;
+    }
+
+    // Step into the neighboring cell whose boundary the ray reaches first.
+    int axis = 0;
+    if (tMax[1] < tMax[axis]) {
+      axis = 1;
+    }
+    if (tMax[2] < tMax[axis]) {
+      axis = 2;
+    }
+    pos[axis] += step[axis];
+    if (pos[axis] < 0 || pos[axis] >= size || tMax[axis] > tExit) {
+      return false;
+    }
+    tMax[axis] += tDelta[axis];
+  }
+}
+
+Cube::~Cube() {
   delete m_textures;
+  delete m_faceTexture;
+  delete m_box;
 }
@@ -0,0 +1,379 @@
+/**
+ * @file cube3.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a compact facelet representation
+ * of a 3x3 cube, and of a move engine which applies face turns to it as
+ * vector byte shuffles.
+ *
+ * Each instruction set has its own shuffle, sequence and batch functions,
+ * compiled for that instruction set with target attributes so that the
+ * library itself needs no special compiler flags. The best supported set is
+ * chosen at run time.
+ */
+
+#include <string.h>
+#include <immintrin.h>
+#include "../include/cube3.h"
+#include "../include/slice_table.h"
+
+// Faces in FaceTurn order, and the axis and side each lies on.
+static const Dim TURN_AXES[6] = { Y, X, Z, Y, X, Z };
+static const bool TURN_POSITIVE[6] = { true, true, true, false, false, false };
+
+Move FaceTurnMove(FaceTurn turn, int size) {
+  int face = turn / 3;
+  int quarters = turn % 3 + 1;
+
+  // Clockwise as seen facing a face is a negative rotation about the
+  // outward normal of the face.
+  if (TURN_POSITIVE[face]) {
+    return Move(TURN_AXES[face], size - 1, 4 - quarters);
+  }
+  return Move(TURN_AXES[face], 0, quarters);
+}
+
+bool MoveFaceTurn(const Move& move, int size, FaceTurn& turn) {
+  bool positive = move.slice == size - 1;
+  if (move.turns == 0 || (!positive && move.slice != 0)) {
+    return false;
+  }
+  int face = 0;
+  while (TURN_AXES[face] != move.axis || TURN_POSITIVE[face] != positive) {
+    face++;
+  }
+  int quarters = positive ? 4 - move.turns : move.turns;
+  turn = static_cast<FaceTurn>(face * 3 + quarters - 1);
+  return true;
+}
+
+Cube3::Cube3() {
+  for (int i = 0; i < 64; i++) {
+    facelets[i] = (i < NUM_FACELETS) ? i / 9 : 0;
+  }
+}
+
+Cube3::Cube3(const CubeState& state) {
+  // Read facelet by facelet, so that the state need not be flushed.
+  for (int face = 0; face < NUM_FACES; face++) {
+    for (int u = 0; u < 3; u++) {
+      for (int v = 0; v < 3; v++) {
+        facelets[(face * 3 + u) * 3 + v] =
+          state.GetFacelet(static_cast<Face>(face), u, v);
+      }
+    }
+  }
+  memset(facelets + NUM_FACELETS, 0, 64 - NUM_FACELETS);
+}
+
+bool Cube3::IsSolved() const {
+  for (int face = 0; face < NUM_FACES; face++) {
+    for (int i = 1; i < 9; i++) {
+      if (facelets[face * 9 + i] != facelets[face * 9]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool Cube3::operator==(const Cube3& other) const {
+  return memcmp(facelets, other.facelets, NUM_FACELETS) == 0;
+}
+
+Cube3Shuffle::Cube3Shuffle() {
+  for (int i = 0; i < 64; i++) {
+    sources[i] = i;
+  }
+  Prepare();
+}
+
+Cube3Shuffle::Cube3Shuffle(FaceTurn turn) {
+  for (int i = 0; i < 64; i++) {
+    sources[i] = i;
+  }
+  SliceTable::ForSize(3).TurnFacelets(sources, FaceTurnMove(turn, 3));
+  Prepare();
+}
+
+void Cube3Shuffle::Prepare() {
+  // pshufb reads within one 16 byte register, and writes zero wherever the
+  // high bit of the mask is set, so each output register is the union of
+  // one shuffle per input register.
+  for (int out = 0; out < 4; out++) {
+    for (int in = 0; in < 4; in++) {
+      for (int k = 0; k < 16; k++) {
+        int source = sources[out * 16 + k];
+        ssse3[out][in][k] = (source / 16 == in) ? source % 16 : 0x80;
+      }
+    }
+  }
+
+  // vpshufb only reads within a 16 byte lane, so sources in the other lane
+  // are reached through a copy of each half with its lanes swapped.
+  for (int out = 0; out < 2; out++) {
+    for (int k = 0; k < 32; k++) {
+      int source = sources[out * 32 + k];
+      int half = source / 32;
+      bool sameLane = ((source % 32) / 16 == k / 16);
+      int in = half + (sameLane ? 0 : 2);
+      for (int i = 0; i < 4; i++) {
+        avx2[out][i][k] = (i == in) ? source % 16 : 0x80;
+      }
+    }
+  }
+}
+
+/**** Scalar ****/
+
+static void ShuffleScalar(uint8_t* facelets, const Cube3Shuffle& shuffle) {
+  uint8_t result[64];
+  for (int i = 0; i < 64; i++) {
+    result[i] = facelets[shuffle.sources[i]];
+  }
+  memcpy(facelets, result, 64);
+}
+
+static void SequenceScalar(uint8_t* facelets,
+                           const Cube3Shuffle* turnShuffles,
+                           const uint8_t* turns, size_t numTurns) {
+  for (size_t i = 0; i < numTurns; i++) {
+    ShuffleScalar(facelets, turnShuffles[turns[i]]);
+  }
+}
+
+static void BatchScalar(Cube3* cubes, size_t numCubes,
+                        const Cube3Shuffle& shuffle) {
+  for (size_t i = 0; i < numCubes; i++) {
+    ShuffleScalar(cubes[i].facelets, shuffle);
+  }
+}
+
+/**** SSSE3: four 16 byte registers ****/
+
+__attribute__((target("ssse3")))
+static inline void ShuffleRegsSSSE3(__m128i state[4],
+                                    const Cube3Shuffle& shuffle) {
+  const __m128i* masks = reinterpret_cast<const __m128i*>(shuffle.ssse3);
+  __m128i result[4];
+  for (int out = 0; out < 4; out++) {
+    const __m128i* m = masks + out * 4;
+    result[out] = _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(state[0], _mm_loadu_si128(m + 0)),
+                     _mm_shuffle_epi8(state[1], _mm_loadu_si128(m + 1))),
+        _mm_or_si128(_mm_shuffle_epi8(state[2], _mm_loadu_si128(m + 2)),
+                     _mm_shuffle_epi8(state[3], _mm_loadu_si128(m + 3))));
+  }
+  for (int i = 0; i < 4; i++) {
+    state[i] = result[i];
+  }
+}
+
+__attribute__((target("ssse3")))
+static void ShuffleSSSE3(uint8_t* facelets, const Cube3Shuffle& shuffle) {
+  __m128i* p = reinterpret_cast<__m128i*>(facelets);
+  __m128i state[4];
+  for (int i = 0; i < 4; i++) {
+    state[i] = _mm_loadu_si128(p + i);
+  }
+  ShuffleRegsSSSE3(state, shuffle);
+  for (int i = 0; i < 4; i++) {
+    _mm_storeu_si128(p + i, state[i]);
+  }
+}
+
+__attribute__((target("ssse3")))
+static void SequenceSSSE3(uint8_t* facelets,
+                          const Cube3Shuffle* turnShuffles,
+                          const uint8_t* turns, size_t numTurns) {
+  __m128i* p = reinterpret_cast<__m128i*>(facelets);
+  __m128i state[4];
+  for (int i = 0; i < 4; i++) {
+    state[i] = _mm_loadu_si128(p + i);
+  }
+  for (size_t t = 0; t < numTurns; t++) {
+    ShuffleRegsSSSE3(state, turnShuffles[turns[t]]);
+  }
+  for (int i = 0; i < 4; i++) {
+    _mm_storeu_si128(p + i, state[i]);
+  }
+}
+
+__attribute__((target("ssse3")))
+static void BatchSSSE3(Cube3* cubes, size_t numCubes,
+                       const Cube3Shuffle& shuffle) {
+  for (size_t c = 0; c < numCubes; c++) {
+    ShuffleSSSE3(cubes[c].facelets, shuffle);
+  }
+}
+
+/**** AVX2: two 32 byte registers ****/
+
+__attribute__((target("avx2")))
+static inline void ShuffleRegsAVX2(__m256i& lo, __m256i& hi,
+                                   const Cube3Shuffle& shuffle) {
+  const __m256i* m = reinterpret_cast<const __m256i*>(shuffle.avx2);
+  __m256i loSwap = _mm256_permute4x64_epi64(lo, 0x4E);
+  __m256i hiSwap = _mm256_permute4x64_epi64(hi, 0x4E);
+  __m256i newLo = _mm256_or_si256(
+      _mm256_or_si256(_mm256_shuffle_epi8(lo, _mm256_loadu_si256(m + 0)),
+                      _mm256_shuffle_epi8(hi, _mm256_loadu_si256(m + 1))),
+      _mm256_or_si256(_mm256_shuffle_epi8(loSwap, _mm256_loadu_si256(m + 2)),
+                      _mm256_shuffle_epi8(hiSwap, _mm256_loadu_si256(m + 3))));
+  __m256i newHi = _mm256_or_si256(
+      _mm256_or_si256(_mm256_shuffle_epi8(lo, _mm256_loadu_si256(m + 4)),
+                      _mm256_shuffle_epi8(hi, _mm256_loadu_si256(m + 5))),
+      _mm256_or_si256(_mm256_shuffle_epi8(loSwap, _mm256_loadu_si256(m + 6)),
+                      _mm256_shuffle_epi8(hiSwap, _mm256_loadu_si256(m + 7))));
+  lo = newLo;
+  hi = newHi;
+}
+
+__attribute__((target("avx2")))
+static void ShuffleAVX2(uint8_t* facelets, const Cube3Shuffle& shuffle) {
+  __m256i* p = reinterpret_cast<__m256i*>(facelets);
+  __m256i lo = _mm256_loadu_si256(p);
+  __m256i hi = _mm256_loadu_si256(p + 1);
+  ShuffleRegsAVX2(lo, hi, shuffle);
+  _mm256_storeu_si256(p, lo);
+  _mm256_storeu_si256(p + 1, hi);
+}
+
+__attribute__((target("avx2")))
+static void SequenceAVX2(uint8_t* facelets,
+                         const Cube3Shuffle* turnShuffles,
+                         const uint8_t* turns, size_t numTurns) {
+  __m256i* p = reinterpret_cast<__m256i*>(facelets);
+  __m256i lo = _mm256_loadu_si256(p);
+  __m256i hi = _mm256_loadu_si256(p + 1);
+  for (size_t t = 0; t < numTurns; t++) {
+    ShuffleRegsAVX2(lo, hi, turnShuffles[turns[t]]);
+  }
+  _mm256_storeu_si256(p, lo);
+  _mm256_storeu_si256(p + 1, hi);
+}
+
+__attribute__((target("avx2")))
+static void BatchAVX2(Cube3* cubes, size_t numCubes,
+                      const Cube3Shuffle& shuffle) {
+  for (size_t c = 0; c < numCubes; c++) {
+    ShuffleAVX2(cubes[c].facelets, shuffle);
+  }
+}
+
+/**** AVX-512 VBMI: one 64 byte register, one vpermb per turn ****/
+
+// The merge-masked form with every lane selected is a plain vpermb, and
+// avoids the undefined pass-through register of _mm512_permutexvar_epi8.
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static inline __m512i PermuteVBMI(__m512i sources, __m512i state) {
+  return _mm512_mask_permutexvar_epi8(state, ~0ULL, sources, state);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static void ShuffleVBMI(uint8_t* facelets, const Cube3Shuffle& shuffle) {
+  __m512i state = _mm512_loadu_si512(facelets);
+  __m512i sources = _mm512_loadu_si512(shuffle.sources);
+  _mm512_storeu_si512(facelets, PermuteVBMI(sources, state));
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static void SequenceVBMI(uint8_t* facelets,
+                         const Cube3Shuffle* turnShuffles,
+                         const uint8_t* turns, size_t numTurns) {
+  __m512i state = _mm512_loadu_si512(facelets);
+  for (size_t t = 0; t < numTurns; t++) {
+    __m512i sources = _mm512_loadu_si512(turnShuffles[turns[t]].sources);
+    state = PermuteVBMI(sources, state);
+  }
+  _mm512_storeu_si512(facelets, state);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static void BatchVBMI(Cube3* cubes, size_t numCubes,
+                      const Cube3Shuffle& shuffle) {
+  __m512i sources = _mm512_loadu_si512(shuffle.sources);
+  for (size_t c = 0; c < numCubes; c++) {
+    __m512i state = _mm512_loadu_si512(cubes[c].facelets);
+    _mm512_storeu_si512(cubes[c].facelets,
+                        PermuteVBMI(sources, state));
+  }
+}
+
+/**** Engine ****/
+
+const Cube3Kernel& Cube3Kernel::Get() {
+  static const Cube3Kernel kernel(NULL);
+  return kernel;
+}
+
+/**
+ * Check whether an instruction set was requested and is supported.
+ *
+ * @param requested The requested set, or NULL for any.
+ * @param name The set to check.
+ * @param supported True if the processor supports the set.
+ * @return True if the set should be used.
+ */
+static bool UseSet(const char* requested, const char* name, bool supported) {
+  return supported && (requested == NULL || strcmp(requested, name) == 0);
+}
+
+Cube3Kernel::Cube3Kernel(const char* instructionSet) {
+  for (int turn = 0; turn < NUM_FACE_TURNS; turn++) {
+    m_turns[turn] = Cube3Shuffle(static_cast<FaceTurn>(turn));
+  }
+
+  // Fall back to the best supported set if the request cannot be met.
+  __builtin_cpu_init();
+  const char* requested = instructionSet;
+  if (requested != NULL &&
+      !UseSet(requested, "avx512vbmi",
+              __builtin_cpu_supports("avx512vbmi")) &&
+      !UseSet(requested, "avx2", __builtin_cpu_supports("avx2")) &&
+      !UseSet(requested, "ssse3", __builtin_cpu_supports("ssse3")) &&
+      strcmp(requested, "scalar") != 0) {
+    requested = NULL;
+  }
+
+  if (UseSet(requested, "avx512vbmi",
+             __builtin_cpu_supports("avx512vbmi"))) {
+    m_name = "avx512vbmi";
+    m_shuffle = ShuffleVBMI;
+    m_sequence = SequenceVBMI;
+    m_batch = BatchVBMI;
+  } else if (UseSet(requested, "avx2", __builtin_cpu_supports("avx2"))) {
+    m_name = "avx2";
+    m_shuffle = ShuffleAVX2;
+    m_sequence = SequenceAVX2;
+    m_batch = BatchAVX2;
+  } else if (UseSet(requested, "ssse3", __builtin_cpu_supports("ssse3"))) {
+    m_name = "ssse3";
+    m_shuffle = ShuffleSSSE3;
+    m_sequence = SequenceSSSE3;
+    m_batch = BatchSSSE3;
+  } else {
+    m_name = "scalar";
+    m_shuffle = ShuffleScalar;
+    m_sequence = SequenceScalar;
+    m_batch = BatchScalar;
+  }
+}
+
+Cube3Shuffle Cube3Kernel::Compose(const uint8_t* turns,
+                                  size_t numTurns) const {
+  // Turning the source indices themselves composes the turns.
+  Cube3Shuffle composed;
+  for (size_t i = 0; i < numTurns; i++) {
+    ShuffleScalar(composed.sources, m_turns[turns[i]]);
+  }
+  composed.Prepare();
+  return composed;
+}
+
+void Cube3Kernel::ApplyBatch(Cube3* cubes, size_t numCubes,
+                             const uint8_t* turns, size_t numTurns) const {
+  m_batch(cubes, numCubes, Compose(turns, numTurns));
+}
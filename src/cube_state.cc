@@ -0,0 +1,186 @@
+/**
+ * @file cube_state.cc
+ * @author Charles Ian Mclees
+ *  
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a headless representation of the
+ * state of a Rubik's cube of any size.
+ */
+
+#include <algorithm>
+#include "../include/cube_state.h"
+
+CubeState::CubeState(int size) :
+  m_size(size),
+  m_facelets(NUM_FACES * size * size) {
+  Reset();
+}
+
+void CubeState::Reset() {
+  int faceSize = m_size * m_size;
+  for (int face = 0; face < NUM_FACES; face++) {
+    for (int i = 0; i < faceSize; i++) {
+      m_facelets[face * faceSize + i] = static_cast<uint8_t>(face);
+    }
+    m_faceTurns[face] = 0;
+  }
+}
+
+void CubeState::Apply(const Move& move) {
+  int a = move.axis;
+  int b = (a + 1) % 3;
+  int c = (a + 2) % 3;
+  int last = m_size - 1;
+
+  // Facelets on the four faces around the slab, cycled as by SliceTable.
+  // Along each face the facelets are evenly spaced in storage however far
+  // behind the face is, so each is found from its first two.
+  const int faces[4] = { b * 2 + 1, c * 2 + 1, b * 2, c * 2 };
+  int first[4], step[4];
+  int cells[4][3];
+  for (int t = 0; t < 2; t++) {
+    for (int i = 0; i < 4; i++) {
+      cells[i][a] = move.slice;
+    }
+    cells[0][b] = last;      cells[0][c] = t;
+    cells[1][b] = last - t;  cells[1][c] = last;
+    cells[2][b] = 0;         cells[2][c] = last - t;
+    cells[3][b] = t;         cells[3][c] = 0;
+    for (int i = 0; i < 4; i++) {
+      int axis = faces[i] / 2;
+      int index = StoredIndex(static_cast<Face>(faces[i]),
+                              cells[i][axis == X ? Y : X],
+                              cells[i][axis == Z ? Y : Z]);
+      if (t == 0) {
+        first[i] = index;
+        step[i] = 0;
+      } else {
+        step[i] = index - first[i];
+      }
+    }
+  }
+
+  int turns = move.turns & 3;
+  uint8_t* p0 = &m_facelets[first[0]];
+  uint8_t* p1 = &m_facelets[first[1]];
+  uint8_t* p2 = &m_facelets[first[2]];
+  uint8_t* p3 = &m_facelets[first[3]];
+  uint8_t t;
+  switch (turns) {
+    case 1:
+      for (int i = 0; i < m_size; i++) {
+        t = *p3;  *p3 = *p2;  *p2 = *p1;  *p1 = *p0;  *p0 = t;
+        p0 += step[0];  p1 += step[1];  p2 += step[2];  p3 += step[3];
+      }
+      break;
+    case 2:
+      for (int i = 0; i < m_size; i++) {
+        t = *p0;  *p0 = *p2;  *p2 = t;
+        t = *p1;  *p1 = *p3;  *p3 = t;
+        p0 += step[0];  p1 += step[1];  p2 += step[2];  p3 += step[3];
+      }
+      break;
+    case 3:
+      for (int i = 0; i < m_size; i++) {
+        t = *p0;  *p0 = *p1;  *p1 = *p2;  *p2 = *p3;  *p3 = t;
+        p0 += step[0];  p1 += step[1];  p2 += step[2];  p3 += step[3];
+      }
+      break;
+  }
+
+  // Outer slabs also turn the face on their side of the cube.
+  if (move.slice == 0) {
+    m_faceTurns[a * 2] = (m_faceTurns[a * 2] + turns) & 3;
+  }
+  if (move.slice == last) {
+    m_faceTurns[a * 2 + 1] = (m_faceTurns[a * 2 + 1] + turns) & 3;
+  }
+}
+
+void CubeState::Apply(const Move* moves, size_t numMoves) {
+  for (size_t i = 0; i < numMoves; i++) {
+    Apply(moves[i]);
+  }
+}
+
+void CubeState::Apply(const Permutation& permutation) {
+  Flush();
+  const std::vector<uint32_t>& sources = permutation.GetSources();
+  m_scratch.resize(m_facelets.size());
+  for (size_t i = 0; i < sources.size(); i++) {
+    m_scratch[i] = m_facelets[sources[i]];
+  }
+  m_facelets.swap(m_scratch);
+}
+
+bool CubeState::IsSolved() const {
+  // Turning a face does not change whether it shows a single color, so
+  // faces which are behind need not be brought up to date.
+  int faceSize = m_size * m_size;
+  for (int face = 0; face < NUM_FACES; face++) {
+    const uint8_t* facelets = &m_facelets[face * faceSize];
+    for (int i = 1; i < faceSize; i++) {
+      if (facelets[i] != facelets[0]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::string CubeState::ToString() const {
+  static const char letters[NUM_FACES] = { 'L', 'R', 'D', 'U', 'B', 'F' };
+
+  int faceSize = m_size * m_size;
+  std::string text;
+  text.reserve(NUM_FACES * (faceSize + 1));
+  for (int face = 0; face < NUM_FACES; face++) {
+    for (int u = 0; u < m_size; u++) {
+      for (int v = 0; v < m_size; v++) {
+        text += letters[GetFacelet(static_cast<Face>(face), u, v)];
+      }
+    }
+    text += '\n';
+  }
+  return text;
+}
+
+bool CubeState::operator==(const CubeState& other) const {
+  if (m_size != other.m_size) {
+    return false;
+  }
+  if (IsFlushed() && other.IsFlushed()) {
+    return m_facelets == other.m_facelets;
+  }
+  for (int face = 0; face < NUM_FACES; face++) {
+    for (int u = 0; u < m_size; u++) {
+      for (int v = 0; v < m_size; v++) {
+        Face f = static_cast<Face>(face);
+        if (GetFacelet(f, u, v) != other.GetFacelet(f, u, v)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void CubeState::Flush() {
+  int faceSize = m_size * m_size;
+  for (int face = 0; face < NUM_FACES; face++) {
+    if (m_faceTurns[face] == 0) {
+      continue;
+    }
+    m_scratch.resize(faceSize);
+    for (int u = 0; u < m_size; u++) {
+      for (int v = 0; v < m_size; v++) {
+        m_scratch[u * m_size + v] =
+          m_facelets[StoredIndex(static_cast<Face>(face), u, v)];
+      }
+    }
+    std::copy(m_scratch.begin(), m_scratch.end(),
+              m_facelets.begin() + face * faceSize);
+    m_faceTurns[face] = 0;
+  }
+}
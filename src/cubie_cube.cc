@@ -0,0 +1,458 @@
+/**
+ * @file cubie_cube.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a 3x3 cube described by the
+ * permutation and orientation of its corner and edge pieces.
+ */
+
+#include "../include/cubie_cube.h"
+
+/**** Facelet geometry ****/
+
+/**
+ * Get the index within Cube3 of the facelet on a face of a block.
+ *
+ * @param face The face.
+ * @param x Position of the block along the x-axis, 0 to 2.
+ * @param y Position of the block along the y-axis, 0 to 2.
+ * @param z Position of the block along the z-axis, 0 to 2.
+ * @return The index of the facelet.
+ */
+static int FaceletIndex(Face face, int x, int y, int z) {
+  int cell[3] = { x, y, z };
+  int axis = face / 2;
+  int u = cell[axis == X ? Y : X];
+  int v = cell[axis == Z ? Y : Z];
+  return (face * 3 + u) * 3 + v;
+}
+
+/**
+ * Facelets of each corner position, starting with the U or D facelet and
+ * going clockwise around the corner.
+ */
+struct CornerFacelets {
+  CornerFacelets() {
+    static const Face faces[NUM_CORNERS][3] = {
+      { FACE_U, FACE_R, FACE_F }, { FACE_U, FACE_F, FACE_L },
+      { FACE_U, FACE_L, FACE_B }, { FACE_U, FACE_B, FACE_R },
+      { FACE_D, FACE_F, FACE_R }, { FACE_D, FACE_L, FACE_F },
+      { FACE_D, FACE_B, FACE_L }, { FACE_D, FACE_R, FACE_B }
+    };
+    static const int cells[NUM_CORNERS][3] = {
+      { 2, 2, 2 }, { 0, 2, 2 }, { 0, 2, 0 }, { 2, 2, 0 },
+      { 2, 0, 2 }, { 0, 0, 2 }, { 0, 0, 0 }, { 2, 0, 0 }
+    };
+    for (int c = 0; c < NUM_CORNERS; c++) {
+      for (int i = 0; i < 3; i++) {
+        face[c][i] = faces[c][i];
+        index[c][i] = FaceletIndex(faces[c][i],
+                                   cells[c][0], cells[c][1], cells[c][2]);
+      }
+    }
+  }
+
+  Face face[NUM_CORNERS][3];
+  int index[NUM_CORNERS][3];
+};
+
+/**
+ * Facelets of each edge position, starting with the U or D facelet, or the
+ * F or B facelet for slice edges.
+ */
+struct EdgeFacelets {
+  EdgeFacelets() {
+    static const Face faces[NUM_EDGES][2] = {
+      { FACE_U, FACE_R }, { FACE_U, FACE_F }, { FACE_U, FACE_L },
+      { FACE_U, FACE_B }, { FACE_D, FACE_R }, { FACE_D, FACE_F },
+      { FACE_D, FACE_L }, { FACE_D, FACE_B }, { FACE_F, FACE_R },
+      { FACE_F, FACE_L }, { FACE_B, FACE_L }, { FACE_B, FACE_R }
+    };
+    static const int cells[NUM_EDGES][3] = {
+      { 2, 2, 1 }, { 1, 2, 2 }, { 0, 2, 1 }, { 1, 2, 0 },
+      { 2, 0, 1 }, { 1, 0, 2 }, { 0, 0, 1 }, { 1, 0, 0 },
+      { 2, 1, 2 }, { 0, 1, 2 }, { 0, 1, 0 }, { 2, 1, 0 }
+    };
+    for (int e = 0; e < NUM_EDGES; e++) {
+      for (int i = 0; i < 2; i++) {
+        face[e][i] = faces[e][i];
+        index[e][i] = FaceletIndex(faces[e][i],
+                                   cells[e][0], cells[e][1], cells[e][2]);
+      }
+    }
+  }
+
+  Face face[NUM_EDGES][2];
+  int index[NUM_EDGES][2];
+};
+
+static const CornerFacelets& GetCornerFacelets() {
+  static const CornerFacelets facelets;
+  return facelets;
+}
+
+static const EdgeFacelets& GetEdgeFacelets() {
+  static const EdgeFacelets facelets;
+  return facelets;
+}
+
+/**** Cubie cube ****/
+
+CubieCube::CubieCube() {
+  for (int i = 0; i < NUM_CORNERS; i++) {
+    cp[i] = i;
+    co[i] = 0;
+  }
+  for (int i = 0; i < NUM_EDGES; i++) {
+    ep[i] = i;
+    eo[i] = 0;
+  }
+}
+
+bool CubieCube::FromFacelets(const Cube3& cube, CubieCube& result) {
+  const CornerFacelets& corners = GetCornerFacelets();
+  const EdgeFacelets& edges = GetEdgeFacelets();
+
+  // Name each color for the face whose center shows it.
+  int colorFace[NUM_FACES];
+  for (int color = 0; color < NUM_FACES; color++) {
+    colorFace[color] = -1;
+  }
+  for (int face = 0; face < NUM_FACES; face++) {
+    int color = cube.facelets[face * 9 + 4];
+    if (color >= NUM_FACES || colorFace[color] != -1) {
+      return false;
+    }
+    colorFace[color] = face;
+  }
+
+  for (int i = 0; i < NUM_CORNERS; i++) {
+    int faces[3];
+    for (int k = 0; k < 3; k++) {
+      int color = cube.facelets[corners.index[i][k]];
+      if (color >= NUM_FACES) {
+        return false;
+      }
+      faces[k] = colorFace[color];
+    }
+
+    // The twist is the position of the U or D facelet.
+    int ori = 0;
+    while (ori < 3 && faces[ori] != FACE_U && faces[ori] != FACE_D) {
+      ori++;
+    }
+    if (ori == 3) {
+      return false;
+    }
+
+    int j = 0;
+    while (j < NUM_CORNERS &&
+           (corners.face[j][0] != faces[ori] ||
+            corners.face[j][1] != faces[(ori + 1) % 3] ||
+            corners.face[j][2] != faces[(ori + 2) % 3])) {
+      j++;
+    }
+    if (j == NUM_CORNERS) {
+      return false;
+    }
+    result.cp[i] = j;
+    result.co[i] = ori;
+  }
+
+  for (int i = 0; i < NUM_EDGES; i++) {
+    int colorA = cube.facelets[edges.index[i][0]];
+    int colorB = cube.facelets[edges.index[i][1]];
+    if (colorA >= NUM_FACES || colorB >= NUM_FACES) {
+      return false;
+    }
+    int a = colorFace[colorA];
+    int b = colorFace[colorB];
+
+    int j = 0;
+    while (j < NUM_EDGES) {
+      if (edges.face[j][0] == a && edges.face[j][1] == b) {
+        result.eo[i] = 0;
+        break;
+      }
+      if (edges.face[j][0] == b && edges.face[j][1] == a) {
+        result.eo[i] = 1;
+        break;
+      }
+      j++;
+    }
+    if (j == NUM_EDGES) {
+      return false;
+    }
+    result.ep[i] = j;
+  }
+
+  return result.IsSolvable();
+}
+
+Cube3 CubieCube::ToFacelets() const {
+  const CornerFacelets& corners = GetCornerFacelets();
+  const EdgeFacelets& edges = GetEdgeFacelets();
+
+  Cube3 cube;
+  for (int i = 0; i < NUM_CORNERS; i++) {
+    for (int k = 0; k < 3; k++) {
+      cube.facelets[corners.index[i][(k + co[i]) % 3]] =
+        corners.face[cp[i]][k];
+    }
+  }
+  for (int i = 0; i < NUM_EDGES; i++) {
+    for (int k = 0; k < 2; k++) {
+      cube.facelets[edges.index[i][(k + eo[i]) % 2]] = edges.face[ep[i]][k];
+    }
+  }
+  return cube;
+}
+
+/**
+ * The cubes reached by each face turn from the solved cube, read from the
+ * facelet move engine so both representations agree on every turn.
+ */
+struct TurnCubes {
+  TurnCubes() {
+    for (int turn = 0; turn < NUM_FACE_TURNS; turn++) {
+      Cube3 cube;
+      Cube3Kernel::Get().Apply(cube, static_cast<FaceTurn>(turn));
+      CubieCube::FromFacelets(cube, cubes[turn]);
+    }
+  }
+
+  CubieCube cubes[NUM_FACE_TURNS];
+};
+
+const CubieCube& CubieCube::Turn(FaceTurn turn) {
+  static const TurnCubes turns;
+  return turns.cubes[turn];
+}
+
+void CubieCube::Multiply(const CubieCube& other) {
+  uint8_t newCp[NUM_CORNERS], newCo[NUM_CORNERS];
+  for (int i = 0; i < NUM_CORNERS; i++) {
+    newCp[i] = cp[other.cp[i]];
+    newCo[i] = (co[other.cp[i]] + other.co[i]) % 3;
+  }
+  uint8_t newEp[NUM_EDGES], newEo[NUM_EDGES];
+  for (int i = 0; i < NUM_EDGES; i++) {
+    newEp[i] = ep[other.ep[i]];
+    newEo[i] = eo[other.ep[i]] ^ other.eo[i];
+  }
+  for (int i = 0; i < NUM_CORNERS; i++) {
+    cp[i] = newCp[i];
+    co[i] = newCo[i];
+  }
+  for (int i = 0; i < NUM_EDGES; i++) {
+    ep[i] = newEp[i];
+    eo[i] = newEo[i];
+  }
+}
+
+CubieCube CubieCube::Inverse() const {
+  CubieCube inverse;
+  for (int i = 0; i < NUM_CORNERS; i++) {
+    inverse.cp[cp[i]] = i;
+    inverse.co[cp[i]] = (3 - co[i]) % 3;
+  }
+  for (int i = 0; i < NUM_EDGES; i++) {
+    inverse.ep[ep[i]] = i;
+    inverse.eo[ep[i]] = eo[i];
+  }
+  return inverse;
+}
+
+/**
+ * Get the parity of a permutation.
+ *
+ * @param perm The permutation.
+ * @param n Number of elements.
+ * @return 0 if even, 1 if odd.
+ */
+static int Parity(const uint8_t* perm, int n) {
+  int parity = 0;
+  for (int i = 0; i < n; i++) {
+    for (int j = i + 1; j < n; j++) {
+      if (perm[j] < perm[i]) {
+        parity ^= 1;
+      }
+    }
+  }
+  return parity;
+}
+
+bool CubieCube::IsSolvable() const {
+  bool cornerSeen[NUM_CORNERS] = { false };
+  int twist = 0;
+  for (int i = 0; i < NUM_CORNERS; i++) {
+    if (cp[i] >= NUM_CORNERS || cornerSeen[cp[i]] || co[i] > 2) {
+      return false;
+    }
+    cornerSeen[cp[i]] = true;
+    twist += co[i];
+  }
+
+  bool edgeSeen[NUM_EDGES] = { false };
+  int flip = 0;
+  for (int i = 0; i < NUM_EDGES; i++) {
+    if (ep[i] >= NUM_EDGES || edgeSeen[ep[i]] || eo[i] > 1) {
+      return false;
+    }
+    edgeSeen[ep[i]] = true;
+    flip += eo[i];
+  }
+
+  return twist % 3 == 0 && flip % 2 == 0 &&
+         Parity(cp, NUM_CORNERS) == Parity(ep, NUM_EDGES);
+}
+
+int CubieCube::GetTwist() const {
+  int twist = 0;
+  for (int i = 0; i < NUM_CORNERS - 1; i++) {
+    twist = 3 * twist + co[i];
+  }
+  return twist;
+}
+
+void CubieCube::SetTwist(int twist) {
+  int sum = 0;
+  for (int i = NUM_CORNERS - 2; i >= 0; i--) {
+    co[i] = twist % 3;
+    sum += co[i];
+    twist /= 3;
+  }
+  co[NUM_CORNERS - 1] = (3 - sum % 3) % 3;
+}
+
+int CubieCube::GetFlip() const {
+  int flip = 0;
+  for (int i = 0; i < NUM_EDGES - 1; i++) {
+    flip = 2 * flip + eo[i];
+  }
+  return flip;
+}
+
+void CubieCube::SetFlip(int flip) {
+  int sum = 0;
+  for (int i = NUM_EDGES - 2; i >= 0; i--) {
+    eo[i] = flip % 2;
+    sum += eo[i];
+    flip /= 2;
+  }
+  eo[NUM_EDGES - 1] = sum % 2;
+}
+
+int CubieCube::GetSlice() const {
+  // Combinatorial number of the slice edge positions, counted from BR.
+  int slice = 0;
+  int found = 0;
+  for (int j = NUM_EDGES - 1; j >= 0; j--) {
+    if (ep[j] >= EDGE_FR) {
+      slice += Choose(NUM_EDGES - 1 - j, found + 1);
+      found++;
+    }
+  }
+  return slice;
+}
+
+void CubieCube::SetSlice(int slice) {
+  int other = EDGE_UR;
+  int sliceEdge = EDGE_FR;
+  int remaining = 3;
+  for (int j = 0; j < NUM_EDGES; j++) {
+    int c = (remaining >= 0) ? Choose(NUM_EDGES - 1 - j, remaining + 1) : -1;
+    if (remaining >= 0 && c <= slice) {
+      ep[j] = sliceEdge++;
+      slice -= c;
+      remaining--;
+    } else {
+      ep[j] = other++;
+    }
+  }
+}
+
+int CubieCube::GetCornerPerm() const {
+  return PermutationRank(cp, NUM_CORNERS);
+}
+
+void CubieCube::SetCornerPerm(int perm) {
+  PermutationUnrank(perm, NUM_CORNERS, cp);
+}
+
+int CubieCube::GetEdge8Perm() const {
+  return PermutationRank(ep, 8);
+}
+
+void CubieCube::SetEdge8Perm(int perm) {
+  PermutationUnrank(perm, 8, ep);
+}
+
+int CubieCube::GetSlicePerm() const {
+  uint8_t perm[4];
+  for (int i = 0; i < 4; i++) {
+    perm[i] = ep[EDGE_FR + i] - EDGE_FR;
+  }
+  return PermutationRank(perm, 4);
+}
+
+void CubieCube::SetSlicePerm(int perm) {
+  uint8_t slice[4];
+  PermutationUnrank(perm, 4, slice);
+  for (int i = 0; i < 4; i++) {
+    ep[EDGE_FR + i] = slice[i] + EDGE_FR;
+  }
+}
+
+/**** Combinatorics ****/
+
+int PermutationRank(const uint8_t* perm, int n) {
+  // Lehmer code: the number of later elements smaller than each element,
+  // in a factorial base.
+  int rank = 0;
+  for (int i = 0; i < n; i++) {
+    int smaller = 0;
+    for (int j = i + 1; j < n; j++) {
+      if (perm[j] < perm[i]) {
+        smaller++;
+      }
+    }
+    rank = rank * (n - i) + smaller;
+  }
+  return rank;
+}
+
+void PermutationUnrank(int rank, int n, uint8_t* perm) {
+  int code[12];
+  for (int i = n - 1; i >= 0; i--) {
+    code[i] = rank % (n - i);
+    rank /= (n - i);
+  }
+
+  bool used[12] = { false };
+  for (int i = 0; i < n; i++) {
+    int skip = code[i];
+    int value = 0;
+    while (used[value] || skip > 0) {
+      if (!used[value]) {
+        skip--;
+      }
+      value++;
+    }
+    used[value] = true;
+    perm[i] = value;
+  }
+}
+
+int Choose(int n, int k) {
+  if (k < 0 || k > n) {
+    return 0;
+  }
+  int result = 1;
+  for (int i = 1; i <= k; i++) {
+    result = result * (n - k + i) / i;
+  }
+  return result;
+}
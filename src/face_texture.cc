@@ -0,0 +1,103 @@
+/**
+ * @file face_texture.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a texture holding the sticker
+ * colors of every face of a cube.
+ */
+
+#include <cassert>
+#include "../include/face_texture.h"
+
+FaceTexture::FaceTexture(const CubeState& state) :
+  m_size(state.GetSize()),
+  m_line(state.GetSize()) {
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+
+  // Each texel is a palette index, so is never blended with its neighbors.
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, m_size, m_size, NUM_FACES, 0,
+               GL_RED, GL_UNSIGNED_BYTE, NULL);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  Update(state);
+}
+
+void FaceTexture::Update(const CubeState& state) {
+  assert(state.GetSize() == m_size);
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, m_size, m_size, NUM_FACES,
+                  GL_RED, GL_UNSIGNED_BYTE, &state.GetFacelets()[0]);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void FaceTexture::Update(const CubeState& state, const Move& move) {
+  assert(state.GetSize() == m_size);
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  // The four faces around the slab.
+  for (int axis = 0; axis < 3; axis++) {
+    if (axis != move.axis) {
+      UpdateLine(state, static_cast<Face>(axis * 2), move);
+      UpdateLine(state, static_cast<Face>(axis * 2 + 1), move);
+    }
+  }
+
+  // Outer slabs also turn the face on their side of the cube.
+  const uint8_t* facelets = NULL;
+  int faceSize = m_size * m_size;
+  for (int positive = 0; positive < 2; positive++) {
+    if (move.slice == (positive ? m_size - 1 : 0)) {
+      if (facelets == NULL) {
+        facelets = &state.GetFacelets()[0];
+      }
+      int face = move.axis * 2 + positive;
+      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, face, m_size, m_size, 1,
+                      GL_RED, GL_UNSIGNED_BYTE, facelets + face * faceSize);
+    }
+  }
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void FaceTexture::UpdateLine(const CubeState& state, Face face,
+                             const Move& move) {
+  // Facelet coordinates are block positions along the remaining axes, in X,
+  // Y, Z order, so the slab crosses a face along a row when its axis is the
+  // first of them and along a column otherwise.
+  int axis = face / 2;
+  bool row = (move.axis == (axis == X ? Y : X));
+  for (int i = 0; i < m_size; i++) {
+    m_line[i] = row ? state.GetFacelet(face, move.slice, i)
+                    : state.GetFacelet(face, i, move.slice);
+  }
+
+  if (row) {
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, move.slice, face, m_size, 1, 1,
+                    GL_RED, GL_UNSIGNED_BYTE, &m_line[0]);
+  } else {
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, move.slice, 0, face, 1, m_size, 1,
+                    GL_RED, GL_UNSIGNED_BYTE, &m_line[0]);
+  }
+}
+
+void FaceTexture::Bind(unsigned int unit) {
+  assert(unit >= 0 && unit <= 31);
+
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+}
+
+FaceTexture::~FaceTexture() {
+  glDeleteTextures(1, &m_texture);
+}
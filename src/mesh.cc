@@ -7,7 +7,8 @@
  * This file contains the implementation of an OpenGL 3D object mesh class.
  */
 
-#include<vector>
+#include <cstddef>
+#include <vector>
 #include "../include/mesh.h"
 
 Mesh::Mesh(Vertex* vertices, unsigned int numVertices, unsigned int* indices,
@@ -41,8 +42,55 @@ void Mesh::Draw() {
   glBindVertexArray(0);
 }
 
+void Mesh::SetInstances(const MeshInstances& instances) {
+  unsigned int n = instances.count;
+  m_numInstances = n;
+  glBindVertexArray(m_vertexArrayObject);
+  UploadInstanceBuffer(INSTANCE_POSX_VB, instances.posX, n * sizeof(float));
+  UploadInstanceBuffer(INSTANCE_POSY_VB, instances.posY, n * sizeof(float));
+  UploadInstanceBuffer(INSTANCE_POSZ_VB, instances.posZ, n * sizeof(float));
+  UploadInstanceBuffer(INSTANCE_ORIENTATION_VB, instances.orientation, n);
+  UploadInstanceBuffer(INSTANCE_TEXTURE_VB, instances.texture, n);
+  UploadInstanceBuffer(INSTANCE_SCALE_VB, instances.scale, n * sizeof(float));
+  UploadInstanceBuffer(INSTANCE_FACECOLORS_VB, instances.faceColors, n * 6);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::UploadInstanceBuffer(int buffer, const void* data,
+                                size_t numBytes) {
+  if (data == NULL) {
+    return;
+  }
+
+  // Orphan the previous contents so the driver need not wait on the GPU.
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertexArrayBuffers[buffer]);
+  glBufferData(GL_ARRAY_BUFFER, numBytes, NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, numBytes, data);
+
+  // An attribute is sourced from its buffer only once the buffer is filled,
+  // so meshes drawn one at a time never read from empty arrays.
+  if (!m_instanceBufferUsed[buffer]) {
+    m_instanceBufferUsed[buffer] = true;
+    InitInstanceAttributes(buffer);
+  }
+}
+
+void Mesh::DrawInstanced() {
+  glBindVertexArray(m_vertexArrayObject);
+
+  glDrawElementsInstanced(GL_TRIANGLES, m_drawCount, GL_UNSIGNED_INT, 0,
+                          m_numInstances);
+
+  glBindVertexArray(0);
+}
+
 void Mesh::InitMesh(const IndexedModel& model) {
   m_drawCount = model.indices.size();
+  m_numInstances = 0;
+  for (int i = 0; i < NUM_BUFFERS; i++) {
+    m_instanceBufferUsed[i] = false;
+  }
 
   glGenVertexArrays(1, &m_vertexArrayObject);
   glBindVertexArray(m_vertexArrayObject);
@@ -81,6 +129,48 @@ void Mesh::InitMesh(const IndexedModel& model) {
   glBindVertexArray(0);
 }
 
+void Mesh::InitInstanceAttributes(int buffer) {
+  // Per-instance attributes advance once per instance instead of per vertex.
+  switch (buffer) {
+    case INSTANCE_ORIENTATION_VB:
+      InitInstanceAttribute(3, buffer, 1, GL_UNSIGNED_BYTE, 0, 0);
+      break;
+    case INSTANCE_TEXTURE_VB:
+      InitInstanceAttribute(4, buffer, 1, GL_UNSIGNED_BYTE, 0, 0);
+      break;
+    case INSTANCE_SCALE_VB:
+      InitInstanceAttribute(5, buffer, 1, GL_FLOAT, 0, 0);
+      break;
+    case INSTANCE_FACECOLORS_VB:
+      // Face colors take two attributes of three faces each.
+      for (unsigned int i = 0; i < 2; i++) {
+        InitInstanceAttribute(6 + i, buffer, 3, GL_UNSIGNED_BYTE, 6, i * 3);
+      }
+      break;
+    case INSTANCE_POSX_VB:
+      InitInstanceAttribute(8, buffer, 1, GL_FLOAT, 0, 0);
+      break;
+    case INSTANCE_POSY_VB:
+      InitInstanceAttribute(9, buffer, 1, GL_FLOAT, 0, 0);
+      break;
+    case INSTANCE_POSZ_VB:
+      InitInstanceAttribute(10, buffer, 1, GL_FLOAT, 0, 0);
+      break;
+  }
+}
+
+void Mesh::InitInstanceAttribute(GLuint location, int buffer,
+                                 GLint components, GLenum type,
+                                 GLsizei stride, size_t offset) {
+  // Integer data is converted to floats, unnormalized, as it is read.
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertexArrayBuffers[buffer]);
+  glEnableVertexAttribArray(location);
+  glVertexAttribPointer(location, components, type, GL_FALSE, stride,
+                        reinterpret_cast<void*>(offset));
+  glVertexAttribDivisor(location, 1);
+}
+
 Mesh::~Mesh() {
+  glDeleteBuffers(NUM_BUFFERS, m_vertexArrayBuffers);
   glDeleteVertexArrays(1, &m_vertexArrayObject);
 }
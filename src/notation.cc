@@ -0,0 +1,253 @@
+/**
+ * @file notation.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a reader of move sequences
+ * written in standard notation.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include "../include/notation.h"
+
+/**
+ * @enum Kinds of letter a turn is named by.
+ */
+enum LetterKind {
+  LETTER_NONE = 0,
+  LETTER_FACE,      // Outer face, or any layers with a prefix.
+  LETTER_WIDE,      // Outer two layers, or more with a prefix.
+  LETTER_ROTATION,  // Whole cube.
+  LETTER_SLICE      // Every inner layer.
+};
+
+/**
+ * The kind of every letter and the face it turns as, looked up in one step
+ * rather than searched for.
+ */
+struct LetterTable {
+  LetterTable() {
+    memset(kinds, LETTER_NONE, sizeof(kinds));
+    memset(faces, 0, sizeof(faces));
+
+    // Face letters in the order of the Face values: a face lies on axis
+    // (face / 2), on its positive side if (face % 2) is 1.
+    const char* faceLetters = "LRDUBF";
+    const char* wideLetters = "lrdubf";
+    for (int face = 0; face < 6; face++) {
+      Set(faceLetters[face], LETTER_FACE, face);
+      Set(wideLetters[face], LETTER_WIDE, face);
+    }
+
+    // Rotations turn as R, U and F do, and inner slices as L, D and F do.
+    Set('x', LETTER_ROTATION, 1);
+    Set('y', LETTER_ROTATION, 3);
+    Set('z', LETTER_ROTATION, 5);
+    Set('M', LETTER_SLICE, 0);
+    Set('E', LETTER_SLICE, 2);
+    Set('S', LETTER_SLICE, 5);
+  }
+
+  void Set(char letter, LetterKind kind, int face) {
+    kinds[static_cast<unsigned char>(letter)] = kind;
+    faces[static_cast<unsigned char>(letter)] = face;
+  }
+
+  uint8_t kinds[256];
+  uint8_t faces[256];
+};
+
+static const LetterTable LETTERS;
+
+// Layer numbers are clamped here, so that huge ones read as off the cube
+// rather than overflowing.
+static const int MAX_LAYER = 1 << 20;
+
+/**
+ * Read a decimal number.
+ *
+ * @param p The next character (to be advanced past the number).
+ * @param end One past the last character.
+ * @param number The number (to be set).
+ * @return True if a number was read, false if p is not at a digit.
+ */
+static bool ReadNumber(const char*& p, const char* end, int& number) {
+  if (p == end || *p < '0' || *p > '9') {
+    return false;
+  }
+  number = 0;
+  while (p != end && *p >= '0' && *p <= '9') {
+    number = std::min(number * 10 + (*p - '0'), MAX_LAYER);
+    p++;
+  }
+  return true;
+}
+
+/**
+ * Check whether a character separates turns.
+ *
+ * @param c The character.
+ * @return True for a space or any control character, such as a tab or line
+ *    break, otherwise false.
+ */
+static inline bool IsSpace(char c) {
+  return static_cast<unsigned char>(c) <= ' ';
+}
+
+/**
+ * Describe a turn which could not be read.
+ *
+ * @param text The start of the text.
+ * @param token The start of the turn.
+ * @param end One past the last character of the text.
+ * @param reason What is wrong with the turn.
+ * @return The description.
+ */
+static std::string TurnError(const char* text, const char* token,
+                             const char* end, const char* reason) {
+  const char* tokenEnd = token;
+  while (tokenEnd != end && !IsSpace(*tokenEnd) && tokenEnd - token < 32) {
+    tokenEnd++;
+  }
+  return std::string(reason) + " \"" + std::string(token, tokenEnd) +
+         "\" at character " + std::to_string(token - text + 1);
+}
+
+Notation::Notation(int size) {
+  m_size = size;
+}
+
+bool Notation::Parse(const char* text, size_t length,
+                     std::vector<Move>& moves, std::string& error) const {
+  // Most turns take about three characters with their separator, and some
+  // turn more than one layer.
+  moves.reserve(moves.size() + length / 2);
+
+  const char* end = text + length;
+  const char* p = text;
+  while (p != end) {
+    if (IsSpace(*p)) {
+      p++;
+      continue;
+    }
+
+    // Layers are counted from 1 at the face. A prefix gives the layer of a
+    // single layer turn, the deepest layer of a wide turn, or a range.
+    const char* token = p;
+    int low = 0, high = 0;
+    bool prefix = ReadNumber(p, end, high);
+    bool range = false;
+    if (prefix && p != end && *p == '-') {
+      p++;
+      low = high;
+      range = true;
+      if (!ReadNumber(p, end, high)) {
+        error = TurnError(text, token, end, "unknown move");
+        return false;
+      }
+    }
+    if (p == end) {
+      error = TurnError(text, token, end, "unknown move");
+      return false;
+    }
+
+    unsigned char letter = *p++;
+    int kind = LETTERS.kinds[letter];
+    int face = LETTERS.faces[letter];
+    int first, last;
+    if (kind == LETTER_FACE && p != end && *p == 'w') {
+      p++;
+      kind = LETTER_WIDE;
+    }
+    if (kind == LETTER_FACE) {
+      first = range ? low : (prefix ? high : 1);
+      last = prefix ? high : 1;
+    } else if (kind == LETTER_WIDE) {
+      first = range ? low : 1;
+      last = prefix ? high : 2;
+    } else if (kind == LETTER_ROTATION && !prefix) {
+      first = 1;
+      last = m_size;
+    } else if (kind == LETTER_SLICE && !prefix) {
+      first = 2;
+      last = m_size - 1;
+    } else {
+      error = TurnError(text, token, end, "unknown move");
+      return false;
+    }
+
+    // A digit counts clockwise quarter turns, and a prime reverses them.
+    int quarters = 1;
+    if (p != end && *p >= '0' && *p <= '9') {
+      quarters = *p++ - '0';
+    }
+    if (p != end && *p == '\'') {
+      p++;
+      quarters = 4 - quarters % 4;
+    }
+    quarters %= 4;
+
+    if (first < 1 || first > last || last > m_size) {
+      error = TurnError(text, token, end, "layers off the cube in move");
+      return false;
+    }
+    if (quarters == 0) {
+      continue;
+    }
+
+    // Clockwise as seen facing a face is a negative rotation about the
+    // outward normal of the face.
+    Dim axis = static_cast<Dim>(face / 2);
+    bool positive = face % 2 == 1;
+    int turns = positive ? 4 - quarters : quarters;
+    int lowSlice = positive ? m_size - last : first - 1;
+    int highSlice = positive ? m_size - first : last - 1;
+    for (int slice = lowSlice; slice <= highSlice; slice++) {
+      moves.push_back(Move(axis, slice, turns));
+    }
+  }
+  return true;
+}
+
+bool Notation::ParseFile(const std::string& fileName,
+                         std::vector<Move>& moves, std::string& error) const {
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    error = "failed to open \"" + fileName + "\"";
+    return false;
+  }
+
+  // One read of the whole file, parsed in place. Pipes cannot be measured
+  // in advance, so they are read in chunks into a growing buffer instead.
+  std::vector<char> text;
+  std::streamoff fileSize = -1;
+  if (file.seekg(0, std::ios::end)) {
+    fileSize = file.tellg();
+  }
+  if (fileSize >= 0 && file.seekg(0, std::ios::beg)) {
+    text.resize(static_cast<size_t>(fileSize));
+    if (!text.empty() && !file.read(&text[0], text.size())) {
+      error = "failed to read \"" + fileName + "\"";
+      return false;
+    }
+  } else {
+    file.clear();
+    const size_t chunkSize = 1 << 20;
+    size_t length = 0;
+    do {
+      text.resize(length + chunkSize);
+      file.read(&text[length], chunkSize);
+      length += file.gcount();
+    } while (file);
+    if (!file.eof()) {
+      error = "failed to read \"" + fileName + "\"";
+      return false;
+    }
+    text.resize(length);
+  }
+  return Parse(text.empty() ? NULL : &text[0], text.size(), moves, error);
+}
@@ -0,0 +1,637 @@
+/**
+ * @file optimal_solver.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of Korf's optimal solver for the 3x3
+ * cube.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "../include/optimal_solver.h"
+#include "../include/table_builder.h"
+
+// Iterations up to this length take too little time to be worth splitting.
+static const int MIN_SPLIT_LENGTH = 12;
+
+// Tasks made for each thread. Subtrees differ in size by orders of
+// magnitude, so many more tasks than threads are needed to balance them.
+static const int TASKS_PER_THREAD = 64;
+
+/**
+ * The positions and orientations of a piece group, searched to build its
+ * pattern database.
+ */
+class OptimalSolver::GroupSpace : public PruneSpace {
+  public:
+    GroupSpace(const OptimalSolver& solver, const PieceGroup& group)
+      : m_solver(solver), m_group(group) {}
+
+    uint64_t GetSize() const {
+      return m_group.numEntries;
+    }
+
+    uint64_t GetGoal() const {
+      uint8_t pos[NUM_EDGES], ori[NUM_EDGES];
+      for (int i = 0; i < m_group.numPositions; i++) {
+        pos[i] = i;
+        ori[i] = 0;
+      }
+      return GroupIndex(m_group, pos, ori);
+    }
+
+    int GetNeighbors(uint64_t index, uint64_t* neighbors) const {
+      uint8_t pos[NUM_EDGES], ori[NUM_EDGES];
+      GroupFromIndex(m_group, index, pos, ori);
+      for (int t = 0; t < NUM_FACE_TURNS; t++) {
+        uint8_t nextPos[NUM_EDGES], nextOri[NUM_EDGES];
+        std::copy(pos, pos + m_group.numPositions, nextPos);
+        std::copy(ori, ori + m_group.numPositions, nextOri);
+        m_solver.TurnPieces(m_group.corners, t, nextPos, nextOri,
+                            m_group.first, m_group.count);
+        neighbors[t] = GroupIndex(m_group, nextPos, nextOri);
+      }
+      return NUM_FACE_TURNS;
+    }
+  protected:
+  private:
+    const OptimalSolver& m_solver;
+    const PieceGroup& m_group;
+};
+
+/**
+ * The tasks dealt to one thread. The thread takes its own tasks from the
+ * front, lowest numbered first, and threads which have run out steal from
+ * the back.
+ */
+class OptimalSolver::TaskQueue {
+  public:
+    void Push(uint32_t task) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.push_back(task);
+    }
+
+    bool Pop(uint32_t& task) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_tasks.empty()) {
+        return false;
+      }
+      task = m_tasks.front();
+      m_tasks.pop_front();
+      return true;
+    }
+
+    bool Steal(uint32_t& task) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_tasks.empty()) {
+        return false;
+      }
+      task = m_tasks.back();
+      m_tasks.pop_back();
+      return true;
+    }
+  protected:
+  private:
+    std::mutex m_mutex;
+    std::deque<uint32_t> m_tasks;
+};
+
+/**
+ * Threads which search the deep iterations of one solve. They are started
+ * when the first iteration is split and joined when the solve ends, so that
+ * each iteration only wakes them and waits for them to finish.
+ */
+class OptimalSolver::WorkerPool {
+  public:
+    explicit WorkerPool(int numWorkers)
+      : m_numWorkers(numWorkers), m_job(NULL), m_round(0), m_running(0),
+        m_stopping(false) {}
+
+    ~WorkerPool() {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+      }
+      m_started.notify_all();
+      for (size_t i = 0; i < m_threads.size(); i++) {
+        m_threads[i].join();
+      }
+    }
+
+    // Run a job on every worker, numbered from 1, and as worker 0 on the
+    // calling thread, returning once all of them have finished it.
+    void Run(const std::function<void(int)>& job) {
+      for (int w = m_threads.size() + 1; w <= m_numWorkers; w++) {
+        m_threads.push_back(std::thread(&WorkerPool::Work, this, w));
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_round++;
+        m_running = m_numWorkers;
+      }
+      m_started.notify_all();
+      job(0);
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (m_running > 0) {
+        m_finished.wait(lock);
+      }
+      m_job = NULL;
+    }
+  protected:
+  private:
+    void Work(int worker) {
+      uint64_t round = 0;  // Last round run; threads start before round 1.
+      for (;;) {
+        const std::function<void(int)>* job;
+        {
+          std::unique_lock<std::mutex> lock(m_mutex);
+          while (!m_stopping && m_round == round) {
+            m_started.wait(lock);
+          }
+          if (m_stopping) {
+            return;
+          }
+          round = m_round;
+          job = m_job;
+        }
+        (*job)(worker);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_running == 0) {
+          m_finished.notify_one();
+        }
+      }
+    }
+
+    int m_numWorkers;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_started;   // A round started, or stopping.
+    std::condition_variable m_finished;  // Every worker finished the round.
+    const std::function<void(int)>* m_job;
+    uint64_t m_round;  // Rounds started.
+    int m_running;     // Workers yet to finish the round.
+    bool m_stopping;
+};
+
+OptimalSolver::OptimalSolver(int edgeGroupSize, int numThreads,
+                             bool deterministic) {
+  m_edgeGroupSize = std::max(6, std::min(edgeGroupSize, 7));
+  m_numThreads = numThreads;
+  if (m_numThreads <= 0) {
+    m_numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_deterministic = deterministic;
+  m_groups[0] = MakeGroup(true, 0, NUM_CORNERS);
+  m_groups[1] = MakeGroup(false, 0, m_edgeGroupSize);
+  m_groups[2] = MakeGroup(false, NUM_EDGES - m_edgeGroupSize,
+                          m_edgeGroupSize);
+
+  // A face turn moves the piece at position turn.cp[i] to position i.
+  for (int t = 0; t < NUM_FACE_TURNS; t++) {
+    const CubieCube& turn = CubieCube::Turn(static_cast<FaceTurn>(t));
+    for (int i = 0; i < NUM_CORNERS; i++) {
+      m_cornerPosMove[t][turn.cp[i]] = i;
+      m_cornerOriMove[t][turn.cp[i]] = turn.co[i];
+    }
+    for (int i = 0; i < NUM_EDGES; i++) {
+      m_edgePosMove[t][turn.ep[i]] = i;
+      m_edgeOriMove[t][turn.ep[i]] = turn.eo[i];
+    }
+  }
+}
+
+bool OptimalSolver::Load(const std::string& directory, bool build,
+                         bool verify) {
+  static const char* names[3] = { "corners", "edges_low", "edges_high" };
+
+  TableBuilder builder;
+  for (int i = 0; i < 3; i++) {
+    const PieceGroup& group = m_groups[i];
+    std::ostringstream path;
+    path << directory << "/" << names[i];
+    if (!group.corners) {
+      path << group.count;
+    }
+    path << ".pdb";
+
+    if (build) {
+      builder.LoadOrBuild(GroupSpace(*this, group), path.str(),
+                          group.pattern, m_databases[i], verify);
+    } else if (!m_databases[i].Open(path.str(), group.pattern,
+                                    group.numEntries, verify)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OptimalSolver::Solve(const CubeState& state,
+                          std::vector<FaceTurn>& solution, int maxLength,
+                          SearchStats* stats) const {
+  if (state.GetSize() != 3) {
+    return false;
+  }
+  return Solve(Cube3(state), solution, maxLength, stats);
+}
+
+bool OptimalSolver::Solve(const Cube3& cube, std::vector<FaceTurn>& solution,
+                          int maxLength, SearchStats* stats) const {
+  CubieCube cubies;
+  if (!CubieCube::FromFacelets(cube, cubies)) {
+    return false;
+  }
+  return Solve(cubies, solution, maxLength, stats);
+}
+
+bool OptimalSolver::Solve(const CubieCube& cube,
+                          std::vector<FaceTurn>& solution, int maxLength,
+                          SearchStats* stats) const {
+  return SolveWithThreads(cube, solution, maxLength, m_numThreads, stats);
+}
+
+void OptimalSolver::Benchmark(const std::vector<CubieCube>& cubes,
+                              int maxLength) const {
+  std::cout << "Solving " << cubes.size() << " cubes on 1 thread and on "
+            << m_numThreads << " threads" << std::endl;
+  double serialSeconds = 0.0;
+  double parallelSeconds = 0.0;
+  for (size_t i = 0; i < cubes.size(); i++) {
+    std::vector<FaceTurn> serial, parallel;
+    SearchStats serialStats, parallelStats;
+    bool solved = SolveWithThreads(cubes[i], serial, maxLength, 1,
+                                   &serialStats);
+    SolveWithThreads(cubes[i], parallel, maxLength, m_numThreads,
+                     &parallelStats);
+    serialSeconds += serialStats.seconds;
+    parallelSeconds += parallelStats.seconds;
+
+    std::cout << "  cube " << std::setw(3) << i + 1 << ": ";
+    if (solved) {
+      std::cout << std::setw(2) << serial.size() << " moves, ";
+    } else {
+      std::cout << "unsolved, ";
+    }
+    std::cout << std::fixed << std::setprecision(3) << serialStats.seconds
+              << " s / " << parallelStats.seconds << " s, "
+              << std::setprecision(1)
+              << serialStats.nodes / serialStats.seconds / 1000000.0
+              << " / "
+              << parallelStats.nodes / parallelStats.seconds / 1000000.0
+              << " M nodes/s, speedup " << std::setprecision(2)
+              << serialStats.seconds / parallelStats.seconds << std::endl;
+
+    // Every solution found is a shortest one, and a deterministic search
+    // must also find the same one.
+    if (serial.size() != parallel.size() ||
+        (m_deterministic && serial != parallel)) {
+      std::cerr << "Solutions of cube " << i + 1 << " differ" << std::endl;
+    }
+  }
+  std::cout << "  total: " << std::fixed << std::setprecision(3)
+            << serialSeconds << " s on 1 thread, " << parallelSeconds
+            << " s on " << m_numThreads << " threads, speedup "
+            << std::setprecision(2) << serialSeconds / parallelSeconds
+            << std::endl;
+}
+
+bool OptimalSolver::SolveWithThreads(const CubieCube& cube,
+                                     std::vector<FaceTurn>& solution,
+                                     int maxLength, int numThreads,
+                                     SearchStats* stats) const {
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  if (stats != NULL) {
+    stats->nodes = 0;
+    stats->seconds = 0.0;
+    stats->numThreads = numThreads;
+  }
+  solution.clear();
+  if (!cube.IsSolvable()) {
+    return false;
+  }
+  for (int i = 0; i < 3; i++) {
+    if (!m_databases[i].IsOpen()) {
+      std::cerr << "Pattern databases are not loaded" << std::endl;
+      return false;
+    }
+  }
+
+  PieceState state;
+  std::vector<uint8_t> moves(maxLength + 1);
+  for (int i = 0; i < NUM_CORNERS; i++) {
+    state.cornerPos[cube.cp[i]] = i;
+    state.cornerOri[cube.cp[i]] = cube.co[i];
+  }
+  for (int i = 0; i < NUM_EDGES; i++) {
+    state.edgePos[cube.ep[i]] = i;
+    state.edgeOri[cube.ep[i]] = cube.eo[i];
+  }
+
+  // Iterative deepening, so the first solution found is a shortest one. The
+  // same threads search every iteration which is split.
+  WorkerPool pool(numThreads - 1);
+  uint64_t nodes = 0;
+  bool found = false;
+  for (int length = Distance(state); length <= maxLength && !found;
+       length++) {
+    if (SearchIteration(state, length, numThreads, &pool, &moves[0],
+                        &nodes)) {
+      for (int i = 0; i < length; i++) {
+        solution.push_back(static_cast<FaceTurn>(moves[i]));
+      }
+      found = true;
+    }
+  }
+
+  if (stats != NULL) {
+    stats->nodes = nodes;
+    stats->seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+  return found;
+}
+
+bool OptimalSolver::SearchIteration(const PieceState& start, int length,
+                                    int numThreads, WorkerPool* pool,
+                                    uint8_t* moves, uint64_t* nodes) const {
+  if (numThreads <= 1 || length <= MIN_SPLIT_LENGTH) {
+    std::vector<PieceState> states(length + 1);
+    states[0] = start;
+    SearchContext context = { NULL, 0, 0 };
+    bool found = Search(&states[0], moves, 0, length, context);
+    *nodes += context.nodes;
+    return found;
+  }
+
+  std::vector<SearchTask> tasks;
+  int splitDepth = MakeTasks(start, length, TASKS_PER_THREAD * numThreads,
+                             tasks);
+  if (tasks.empty()) {
+    return false;
+  }
+
+  // Deal the tasks out in turn, so that every thread starts on one of the
+  // lowest numbered tasks.
+  std::vector<TaskQueue> queues(numThreads);
+  for (size_t i = 0; i < tasks.size(); i++) {
+    queues[i % numThreads].Push(i);
+  }
+
+  std::atomic<uint64_t> firstSolved(tasks.size());
+  std::mutex solutionMutex;
+  std::vector<uint64_t> threadNodes(numThreads, 0);
+  pool->Run([&](int worker) {
+    SearchTasks(&tasks, splitDepth, length, &queues, worker,
+                m_deterministic, &firstSolved, moves, &solutionMutex,
+                &threadNodes[worker]);
+  });
+
+  for (int t = 0; t < numThreads; t++) {
+    *nodes += threadNodes[t];
+  }
+  return firstSolved.load() < tasks.size();
+}
+
+int OptimalSolver::MakeTasks(const PieceState& start, int length,
+                             size_t numTasks,
+                             std::vector<SearchTask>& tasks) const {
+  tasks.assign(1, SearchTask());
+  tasks[0].state = start;
+
+  // Each task is split in the order Search() turns faces, and pruned as it
+  // would be, so the tasks stay in the order they would be searched.
+  int depth = 0;
+  while (tasks.size() < numTasks && depth < MAX_SPLIT_DEPTH &&
+         depth < length - 1) {
+    std::vector<SearchTask> split;
+    for (size_t i = 0; i < tasks.size(); i++) {
+      int lastFace = depth > 0 ? TurnFace(tasks[i].moves[depth - 1]) : -1;
+      for (int t = 0; t < NUM_FACE_TURNS; t++) {
+        if (!CanFollow(TurnFace(t), lastFace)) {
+          t += 2;
+          continue;
+        }
+        SearchTask next = tasks[i];
+        TurnPieces(true, t, next.state.cornerPos, next.state.cornerOri, 0,
+                   NUM_CORNERS);
+        TurnPieces(false, t, next.state.edgePos, next.state.edgeOri, 0,
+                   NUM_EDGES);
+        if (Distance(next.state) < length - depth) {
+          next.moves[depth] = t;
+          split.push_back(next);
+        }
+      }
+    }
+    tasks.swap(split);
+    depth++;
+  }
+  return depth;
+}
+
+void OptimalSolver::SearchTasks(const std::vector<SearchTask>* tasks,
+                                int splitDepth, int length,
+                                std::vector<TaskQueue>* queues, int worker,
+                                bool deterministic,
+                                std::atomic<uint64_t>* firstSolved,
+                                uint8_t* solution, std::mutex* solutionMutex,
+                                uint64_t* nodes) const {
+  int numQueues = queues->size();
+  std::vector<PieceState> states(length + 1);
+  std::vector<uint8_t> moves(length);
+  SearchContext context = { firstSolved, 0, 0 };
+
+  for (;;) {
+    uint32_t task;
+    bool taken = (*queues)[worker].Pop(task);
+    for (int i = 1; i < numQueues && !taken; i++) {
+      taken = (*queues)[(worker + i) % numQueues].Steal(task);
+    }
+    if (!taken) {
+      break;  // No tasks are added once searching starts, so all are done.
+    }
+
+    // Any solution is a shortest one, so unless the solution must be the
+    // one a single thread would find, the first found ends the iteration.
+    context.priority = deterministic ? task : tasks->size();
+    if (firstSolved->load(std::memory_order_relaxed) < context.priority) {
+      continue;
+    }
+
+    const SearchTask& start = (*tasks)[task];
+    states[splitDepth] = start.state;
+    std::copy(start.moves, start.moves + splitDepth, moves.begin());
+    if (Search(&states[0], &moves[0], splitDepth, length - splitDepth,
+               context)) {
+      std::lock_guard<std::mutex> lock(*solutionMutex);
+      if (task < firstSolved->load()) {
+        std::copy(moves.begin(), moves.end(), solution);
+        firstSolved->store(task);
+      }
+    }
+  }
+  *nodes = context.nodes;
+}
+
+OptimalSolver::PieceGroup OptimalSolver::MakeGroup(bool corners, int first,
+                                                   int count) {
+  PieceGroup group;
+  group.corners = corners;
+  group.first = first;
+  group.count = count;
+  group.numPositions = corners ? static_cast<int>(NUM_CORNERS)
+                               : static_cast<int>(NUM_EDGES);
+  group.numOrientations = corners ? 3 : 2;
+  group.orientedPieces = (count == group.numPositions) ? count - 1 : count;
+  group.pattern = (corners ? 0x10000 : 0x20000) | (first << 8) | count;
+
+  group.numOrientationSets = 1;
+  for (int i = 0; i < group.orientedPieces; i++) {
+    group.numOrientationSets *= group.numOrientations;
+  }
+  group.numEntries = group.numOrientationSets;
+  for (int i = 0; i < count; i++) {
+    group.numEntries *= group.numPositions - i;
+  }
+  return group;
+}
+
+uint64_t OptimalSolver::GroupIndex(const PieceGroup& group,
+                                   const uint8_t* pos, const uint8_t* ori) {
+  // Each position is numbered among the positions not yet taken by earlier
+  // pieces of the group.
+  uint64_t perm = 0;
+  uint32_t used = 0;
+  for (int i = 0; i < group.count; i++) {
+    int p = pos[group.first + i];
+    int digit = p - __builtin_popcount(used & ((1u << p) - 1));
+    perm = perm * (group.numPositions - i) + digit;
+    used |= 1u << p;
+  }
+
+  uint64_t orientation = 0;
+  for (int i = 0; i < group.orientedPieces; i++) {
+    orientation = orientation * group.numOrientations + ori[group.first + i];
+  }
+  return perm * group.numOrientationSets + orientation;
+}
+
+void OptimalSolver::GroupFromIndex(const PieceGroup& group, uint64_t index,
+                                   uint8_t* pos, uint8_t* ori) {
+  uint64_t orientation = index % group.numOrientationSets;
+  uint64_t perm = index / group.numOrientationSets;
+
+  int sum = 0;
+  for (int i = group.orientedPieces - 1; i >= 0; i--) {
+    ori[group.first + i] = orientation % group.numOrientations;
+    sum += ori[group.first + i];
+    orientation /= group.numOrientations;
+  }
+  if (group.orientedPieces < group.count) {
+    ori[group.first + group.count - 1] =
+      (group.numOrientations - sum % group.numOrientations) %
+      group.numOrientations;
+  }
+
+  int digits[NUM_EDGES];
+  for (int i = group.count - 1; i >= 0; i--) {
+    digits[i] = perm % (group.numPositions - i);
+    perm /= group.numPositions - i;
+  }
+  uint32_t used = 0;
+  for (int i = 0; i < group.count; i++) {
+    int p = 0;
+    for (int skip = digits[i]; skip > 0 || (used & (1u << p)); p++) {
+      if (!(used & (1u << p))) {
+        skip--;
+      }
+    }
+    pos[group.first + i] = p;
+    used |= 1u << p;
+  }
+}
+
+void OptimalSolver::TurnPieces(bool corners, int turn, uint8_t* pos,
+                               uint8_t* ori, int first, int count) const {
+  if (corners) {
+    for (int i = first; i < first + count; i++) {
+      int p = pos[i];
+      pos[i] = m_cornerPosMove[turn][p];
+      ori[i] += m_cornerOriMove[turn][p];
+      ori[i] -= (ori[i] >= 3) ? 3 : 0;
+    }
+  } else {
+    for (int i = first; i < first + count; i++) {
+      int p = pos[i];
+      pos[i] = m_edgePosMove[turn][p];
+      ori[i] ^= m_edgeOriMove[turn][p];
+    }
+  }
+}
+
+int OptimalSolver::Distance(const PieceState& state) const {
+  return std::max(GroupDistance(state, 0),
+                  std::max(GroupDistance(state, 1), GroupDistance(state, 2)));
+}
+
+int OptimalSolver::GroupDistance(const PieceState& state, int group) const {
+  if (group == 0) {
+    return m_databases[0].Get(
+      GroupIndex(m_groups[0], state.cornerPos, state.cornerOri));
+  }
+  return m_databases[group].Get(
+    GroupIndex(m_groups[group], state.edgePos, state.edgeOri));
+}
+
+bool OptimalSolver::Search(PieceState* states, uint8_t* moves, int depth,
+                           int togo, SearchContext& context) const {
+  context.nodes++;
+  if (context.firstSolved != NULL &&
+      context.firstSolved->load(std::memory_order_relaxed) <
+        context.priority) {
+    return false;
+  }
+
+  // The distance is at most togo, as the caller looked it up, and the edge
+  // groups overlap to cover every edge, so with no moves left the cube is
+  // solved.
+  if (togo == 0) {
+    return true;
+  }
+
+  int lastFace = depth > 0 ? TurnFace(moves[depth - 1]) : -1;
+  for (int t = 0; t < NUM_FACE_TURNS; t++) {
+    if (!CanFollow(TurnFace(t), lastFace)) {
+      t += 2;
+      continue;
+    }
+    // The bounds are looked up one at a time, stopping at the first which
+    // prunes the turn, and the edges are only turned once the corners have
+    // not pruned it.
+    PieceState& next = states[depth + 1];
+    next = states[depth];
+    TurnPieces(true, t, next.cornerPos, next.cornerOri, 0, NUM_CORNERS);
+    if (GroupDistance(next, 0) >= togo) {
+      continue;
+    }
+    TurnPieces(false, t, next.edgePos, next.edgeOri, 0, NUM_EDGES);
+    if (GroupDistance(next, 1) >= togo || GroupDistance(next, 2) >= togo) {
+      continue;
+    }
+    moves[depth] = t;
+    if (Search(states, moves, depth + 1, togo - 1, context)) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file orientation.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of the group of 24 rotations which
+ * carry a cube onto itself.
+ */
+
+#include <cstring>
+#include "../include/orientation.h"
+
+const OrientationGroup& OrientationGroup::Get() {
+  static const OrientationGroup group;
+  return group;
+}
+
+OrientationGroup::OrientationGroup() {
+  // Rotations as integer matrices, indexed [row][column], so that comparing
+  // them is exact.
+  int rotations[NUM_ORIENTATIONS][3][3];
+  memset(rotations[0], 0, sizeof(rotations[0]));
+  for (int i = 0; i < 3; i++) {
+    rotations[0][i][i] = 1;
+  }
+
+  // Walk outwards from the starting orientation, turning each one found
+  // about every axis in both directions.
+  int count = 1;
+  for (int o = 0; o < count; o++) {
+    for (int a = 0; a < 3; a++) {
+      // Axes b and c follow a cyclically, so that a clockwise quarter turn
+      // about a carries +b to +c and +c to -b.
+      int b = (a + 1) % 3;
+      int c = (a + 2) % 3;
+      for (int clockwise = 0; clockwise < 2; clockwise++) {
+        int quarter[3][3];
+        memset(quarter, 0, sizeof(quarter));
+        quarter[a][a] = 1;
+        quarter[c][b] = clockwise ? 1 : -1;
+        quarter[b][c] = clockwise ? -1 : 1;
+
+        int turned[3][3];
+        for (int row = 0; row < 3; row++) {
+          for (int col = 0; col < 3; col++) {
+            turned[row][col] = 0;
+            for (int k = 0; k < 3; k++) {
+              turned[row][col] += quarter[row][k] * rotations[o][k][col];
+            }
+          }
+        }
+
+        int n = 0;
+        while (n < count &&
+               memcmp(rotations[n], turned, sizeof(turned)) != 0) {
+          n++;
+        }
+        if (n == count) {
+          memcpy(rotations[count++], turned, sizeof(turned));
+        }
+        m_turns[o][a][clockwise] = n;
+      }
+    }
+  }
+
+  // glm matrices are indexed [column][row].
+  for (int o = 0; o < NUM_ORIENTATIONS; o++) {
+    m_matrices[o] = glm::mat4();
+    for (int row = 0; row < 3; row++) {
+      for (int col = 0; col < 3; col++) {
+        m_matrices[o][col][row] = static_cast<float>(rotations[o][row][col]);
+      }
+    }
+  }
+}
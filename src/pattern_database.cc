@@ -0,0 +1,155 @@
+/**
+ * @file pattern_database.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a memory-mapped pattern database.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include "../include/pattern_database.h"
+
+PatternDatabase::PatternDatabase() {
+  m_map = NULL;
+  m_mapSize = 0;
+  m_data = NULL;
+}
+
+bool PatternDatabase::Open(const std::string& path, uint32_t pattern,
+                           uint64_t numEntries, bool verify) {
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<uint64_t>(info.st_size) < sizeof(PatternFileHeader)) {
+    close(fd);
+    return false;
+  }
+  void* map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);  // The mapping keeps the file open.
+  if (map == MAP_FAILED) {
+    return false;
+  }
+
+  const PatternFileHeader* header =
+    static_cast<const PatternFileHeader*>(map);
+  if (header->magic != PatternFileHeader::MAGIC ||
+      header->version != PatternFileHeader::VERSION ||
+      header->pattern != pattern || header->numEntries != numEntries ||
+      header->dataOffset + (numEntries + 1) / 2 >
+        static_cast<uint64_t>(info.st_size)) {
+    std::cerr << "Pattern database \"" << path << "\" does not match"
+              << std::endl;
+    munmap(map, info.st_size);
+    return false;
+  }
+  const uint8_t* data = static_cast<const uint8_t*>(map) + header->dataOffset;
+  if (verify && Checksum(data, (numEntries + 1) / 2) != header->checksum) {
+    std::cerr << "Pattern database \"" << path << "\" is corrupt"
+              << std::endl;
+    munmap(map, info.st_size);
+    return false;
+  }
+
+  // Lookups land on random pages, so reading ahead only wastes page cache.
+  madvise(map, info.st_size, MADV_RANDOM);
+
+  m_map = map;
+  m_mapSize = info.st_size;
+  m_data = data;
+  return true;
+}
+
+void PatternDatabase::Adopt(std::vector<uint8_t>& table) {
+  Close();
+  m_table.swap(table);
+  m_data = &m_table[0];
+}
+
+void PatternDatabase::Close() {
+  if (m_map != NULL) {
+    munmap(m_map, m_mapSize);
+  }
+  m_map = NULL;
+  m_mapSize = 0;
+  m_table.clear();
+  m_data = NULL;
+}
+
+bool PatternDatabase::Write(const std::string& path, uint32_t pattern,
+                            const std::vector<uint8_t>& table,
+                            uint64_t numEntries) {
+  PatternFileHeader header;
+  header.magic = PatternFileHeader::MAGIC;
+  header.version = PatternFileHeader::VERSION;
+  header.pattern = pattern;
+  header.reserved = 0;
+  header.numEntries = numEntries;
+  header.dataOffset = 4096;
+  header.checksum = Checksum(&table[0], table.size());
+
+  // The temporary name is unique, so processes building the same table at
+  // once never write into each other's files.
+  std::vector<char> tempName(path.begin(), path.end());
+  const char* suffix = ".tmp.XXXXXX";
+  tempName.insert(tempName.end(), suffix, suffix + strlen(suffix) + 1);
+  int fd = mkstemp(&tempName[0]);
+  if (fd < 0) {
+    std::cerr << "Failed to write pattern database \"" << path << "\""
+              << std::endl;
+    return false;
+  }
+  fchmod(fd, 0644);
+  close(fd);
+  std::string tempPath(&tempName[0]);
+  std::ofstream file(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    std::cerr << "Failed to write pattern database \"" << path << "\""
+              << std::endl;
+    remove(tempPath.c_str());
+    return false;
+  }
+  std::vector<char> padding(header.dataOffset - sizeof(header), 0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(&padding[0], padding.size());
+  file.write(reinterpret_cast<const char*>(&table[0]), table.size());
+  file.close();
+  if (file.fail() || rename(tempPath.c_str(), path.c_str()) != 0) {
+    std::cerr << "Failed to write pattern database \"" << path << "\""
+              << std::endl;
+    remove(tempPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+uint64_t PatternDatabase::Checksum(const uint8_t* table, size_t size) {
+  // FNV-1a, taking eight bytes at a time.
+  uint64_t hash = 14695981039346656037ULL;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, table + i, 8);
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+  for (; i < size; i++) {
+    hash = (hash ^ table[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+PatternDatabase::~PatternDatabase() {
+  Close();
+}
@@ -0,0 +1,84 @@
+/**
+ * @file permutation.cc
+ * @author Charles Ian Mclees
+ *  
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a permutation of the facelets of
+ * a cube.
+ */
+
+#include "../include/permutation.h"
+#include "../include/cube_state.h"
+#include "../include/slice_table.h"
+
+Permutation::Permutation(int size) :
+  m_size(size),
+  m_sources(NUM_FACES * size * size) {
+  for (size_t i = 0; i < m_sources.size(); i++) {
+    m_sources[i] = i;
+  }
+}
+
+Permutation::Permutation(int size, const Move* moves, size_t numMoves) :
+  m_size(size),
+  m_sources(NUM_FACES * size * size) {
+  for (size_t i = 0; i < m_sources.size(); i++) {
+    m_sources[i] = i;
+  }
+
+  // Turning the source indices themselves composes the moves.
+  const SliceTable& table = SliceTable::ForSize(size);
+  for (size_t i = 0; i < numMoves; i++) {
+    table.TurnFacelets(&m_sources[0], moves[i]);
+  }
+}
+
+void Permutation::Apply(const Move& move) {
+  SliceTable::ForSize(m_size).TurnFacelets(&m_sources[0], move);
+}
+
+Permutation Permutation::Inverse() const {
+  Permutation inverse(m_size);
+  for (size_t i = 0; i < m_sources.size(); i++) {
+    inverse.m_sources[m_sources[i]] = i;
+  }
+  return inverse;
+}
+
+uint64_t Permutation::Order() const {
+  // The least common multiple of the lengths of every cycle.
+  std::vector<bool> visited(m_sources.size(), false);
+  uint64_t order = 1;
+  for (size_t i = 0; i < m_sources.size(); i++) {
+    if (visited[i]) {
+      continue;
+    }
+    uint64_t length = 0;
+    for (size_t j = i; !visited[j]; j = m_sources[j]) {
+      visited[j] = true;
+      length++;
+    }
+
+    uint64_t a = order, b = length;
+    while (b != 0) {
+      uint64_t t = a % b;
+      a = b;
+      b = t;
+    }
+    uint64_t factor = length / a;
+    if (order > UINT64_MAX / factor) {
+      return 0;
+    }
+    order *= factor;
+  }
+  return order;
+}
+
+void Permutation::Then(const Permutation& next) {
+  std::vector<uint32_t> sources(m_sources.size());
+  for (size_t i = 0; i < sources.size(); i++) {
+    sources[i] = m_sources[next.m_sources[i]];
+  }
+  m_sources.swap(sources);
+}
@@ -7,8 +7,17 @@
  * This file contains the main function for a Rubik's Cube game.
  */
 
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <future>
+#include <iostream>
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
 #include <SDL2/SDL.h>
 #include "../include/display.h"
@@ -17,6 +26,9 @@
 #include "../include/camera.h"
 #include "../include/transform.h"
 #include "../include/cube.h"
+#include "../include/notation.h"
+#include "../include/optimal_solver.h"
+#include "../include/two_phase.h"
 
 /**
  * Function to load settings from file "settings.conf"
@@ -25,10 +37,21 @@
  * @param winHeight The desired window height (to be set).
  * @param winWidth The desired window length (to be set).
  * @param mouseSens The desired mouse sensitivity (to be set).
+ * @param instanced True if the cube is to be drawn with instanced rendering
+ *    (to be set).
+ * @param procedural True if stickers are to be colored in the shader rather
+ *    than from block textures (to be set).
+ * @param faceTextures True if each face is to be drawn as one texture of
+ *    stickers rather than block by block (to be set).
+ * @param movesPerSecond The desired speed of animated turns (to be set).
+ * @param parallelTurns True if queued turns of different slices about the
+ *    same axis are to be animated together (to be set).
  * @return True if loading is successful, otherwise false.
  */
 bool LoadSettings(int& cubeSize, int& winHeight,
-                  int& winWidth, float& mouseSens);
+                  int& winWidth, float& mouseSens, bool& instanced,
+                  bool& procedural, bool& faceTextures,
+                  float& movesPerSecond, bool& parallelTurns);
 
 /**
  * Function to process user input and carry out any indicated operations.
@@ -38,18 +61,92 @@ bool LoadSettings(int& cubeSize, int& winHeight,
  * @camera Camera object to control perspective.
  * @cube Cube object on which to carry out indicated operations.
  * @param mouseSens Mouse sensitivity.
+ * @param solverLoaded Ready once the solver has been loaded.
  */
 void ProcessInput(bool& quit, bool& rightClick, Camera& camera,
-                  Cube& cube, float& mouseSens);
+                  Cube& cube, float& mouseSens,
+                  std::future<void>& solverLoaded);
+
+/**
+ * Function to solve a 3x3 cube and queue the solution on it to be animated.
+ *    Nothing is queued until the solver has been loaded.
+ *
+ * @param cube Cube object to be solved.
+ * @param solverLoaded Ready once the solver has been loaded.
+ */
+void QueueSolution(Cube& cube, std::future<void>& solverLoaded);
+
+/**
+ * Function to read a whole number from a command line argument.
+ *
+ * @param arg The argument.
+ * @param number The number (to be set).
+ * @return True if the argument is a whole number in range, otherwise false.
+ */
+bool ReadNumberArg(const char* arg, int& number);
+
+/**
+ * Function to time the optimal solver on random cubes, on one thread and on
+ * every core, without opening a window.
+ *
+ * @param numCubes Number of cubes to solve.
+ * @param scrambleLength Number of random face turns scrambling each cube.
+ * @param deterministic True to check that every thread count finds the same
+ *    solutions.
+ * @return Exit status of the program.
+ */
+int RunBenchmark(int numCubes, int scrambleLength, bool deterministic);
+
+/**
+ * Function to time random slice turns on the headless state of a cube of any
+ * size, without opening a window.
+ *
+ * @param size Number of blocks along each edge of the cube.
+ * @param numMoves Number of random slice turns to make.
+ * @return Exit status of the program.
+ */
+int RunScramble(int size, int numMoves);
 
 /**
  * Main function to run a Rubik's Cube game.
+ *
+ * Run with "--benchmark [cubes] [scramble length] [--deterministic]" to
+ * benchmark the optimal solver instead, or with "--scramble [size] [moves]"
+ * to time slice turns on a large cube. Run with "--moves [file]" to start
+ * the game with the moves in a file, written in standard notation, applied.
  */
-int main() {
+int main(int argc, char* argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+    bool deterministic = std::string(argv[argc - 1]) == "--deterministic";
+    int numArgs = argc - (deterministic ? 1 : 0);
+    int numCubes = 10, scrambleLength = 30;
+    if (numArgs > 4 || (numArgs > 2 && !ReadNumberArg(argv[2], numCubes)) ||
+        (numArgs > 3 && !ReadNumberArg(argv[3], scrambleLength))) {
+      std::cerr << "Usage: " << argv[0] << " --benchmark [cubes] "
+                << "[scramble length] [--deterministic]" << std::endl;
+      return 1;
+    }
+    return RunBenchmark(numCubes, scrambleLength, deterministic);
+  }
+  if (argc > 1 && std::string(argv[1]) == "--scramble") {
+    int size = 500, numMoves = 1000000;
+    if (argc > 4 || (argc > 2 && !ReadNumberArg(argv[2], size)) ||
+        (argc > 3 && !ReadNumberArg(argv[3], numMoves))) {
+      std::cerr << "Usage: " << argv[0] << " --scramble [size] [moves]"
+                << std::endl;
+      return 1;
+    }
+    return RunScramble(size, numMoves);
+  }
+
   // Load Settings.
   int cubeSize, winHeight, winWidth;
   float mouseSens;
-  if (!LoadSettings(cubeSize, winHeight, winWidth, mouseSens)) {
+  float movesPerSecond;
+  bool instanced, procedural, faceTextures, parallelTurns;
+  if (!LoadSettings(cubeSize, winHeight, winWidth, mouseSens, instanced,
+                    procedural, faceTextures, movesPerSecond,
+                    parallelTurns)) {
     SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
                              "Error",
                              "Failed to load settings from \"settings.conf\"",
@@ -63,7 +160,13 @@ int main() {
   // Load 3D data for a block model.
   Mesh blockMesh("./data/model/block.obj");
   // Initialize shader.
-  Shader shader("./data/shader/basicShader");
+  std::string shaderName = instanced ? "instanced" : "basic";
+  if (faceTextures) {
+    shaderName = "face";
+  } else if (procedural) {
+    shaderName = instanced ? "instancedSticker" : "sticker";
+  }
+  Shader shader("./data/shader/" + shaderName + "Shader");
   // Create a camera object to manipulate positional perspective.
   Camera camera(70.0f, static_cast<float>(winWidth) / winHeight, 0.01f,
                 1000.0f, (cubeSize + 1.0f) * 3.0f);
@@ -71,10 +174,36 @@ int main() {
   // on block objects.
   Transform transform;
   // Create a cube object of desired size.
-  Cube cube(cubeSize);
+  Cube cube(cubeSize, instanced, procedural, faceTextures);
+  cube.SetMovesPerSecond(movesPerSecond);
+  cube.SetParallelTurns(parallelTurns);
+  if (argc > 2 && std::string(argv[1]) == "--moves") {
+    std::vector<Move> moves;
+    std::string error;
+    if (!Notation(cubeSize).ParseFile(argv[2], moves, error)) {
+      std::cerr << "Failed to load moves: " << error << std::endl;
+      return 1;
+    }
+    cube.ApplyMoves(moves.empty() ? NULL : &moves[0], moves.size());
+  }
+  // Load the solver on a worker thread, as its tables may take a while to
+  // build the first time, and the window must keep drawing meanwhile.
+  std::future<void> solverLoaded;
+  if (cubeSize == 3) {
+    solverLoaded = std::async(std::launch::async,
+                              [] { TwoPhaseSolver::Get(); });
+  }
 
   bool quit       = false,  // True when the user has closed the window.
        rightClick = false;  // True when right mouse button is held down.
+
+  // The cube advances in fixed ticks of simulated time, however long each
+  // frame takes to draw, and is drawn part way to its next tick.
+  typedef std::chrono::steady_clock Clock;
+  const double tickSeconds = 1.0 / Cube::TICKS_PER_SECOND;
+  const double maxFrameSeconds = 0.25;  // Longer stalls are not caught up.
+  Clock::time_point lastFrame = Clock::now();
+  double unsimulated = 0.0;  // Seconds elapsed but not yet simulated.
   // Iterate over drawn frames.
   while (!display.IsClosed()) {
     display.Clear(0.0f, 0.15f, 0.3f, 1.0f);
@@ -82,12 +211,21 @@ int main() {
     // Change camera position and orientation.
     camera.PositionCam();
 
-    // Continue any current cube animations.
-    cube.UpdateRotation();
+    Clock::time_point now = Clock::now();
+    unsimulated += std::chrono::duration<double>(now - lastFrame).count();
+    unsimulated = std::min(unsimulated, maxFrameSeconds);
+    lastFrame = now;
+    while (unsimulated >= tickSeconds) {
+      // Continue any current cube animations, starting queued turns as
+      // earlier ones finish.
+      cube.UpdateRotation();
+      unsimulated -= tickSeconds;
+    }
 
-    cube.Draw(shader, transform, camera, blockMesh);
+    cube.Draw(shader, transform, camera, blockMesh,
+              static_cast<float>(unsimulated / tickSeconds));
 
-    ProcessInput(quit, rightClick, camera, cube, mouseSens);
+    ProcessInput(quit, rightClick, camera, cube, mouseSens, solverLoaded);
 
     display.Update(quit);
   }
@@ -95,11 +233,18 @@ int main() {
 }
 
 bool LoadSettings(int& cubeSize, int& winHeight,
-                  int& winWidth, float& mouseSens) {
+                  int& winWidth, float& mouseSens, bool& instanced,
+                  bool& procedural, bool& faceTextures,
+                  float& movesPerSecond, bool& parallelTurns) {
   cubeSize = 0;
   winHeight = 0;
   winWidth = 0;
   mouseSens = 0.0f;
+  instanced = false;
+  procedural = false;
+  faceTextures = false;
+  movesPerSecond = 0.0f;
+  parallelTurns = false;
 
   std::ifstream settingsFile("settings.conf");
   std::string line;
@@ -115,6 +260,16 @@ bool LoadSettings(int& cubeSize, int& winHeight,
           winHeight = stoi(line.substr(15));
         } else if (lineNum == 12) {
           mouseSens = stof(line.substr(13));
+        } else if (lineNum == 15) {
+          instanced = (stoi(line.substr(21)) != 0);
+        } else if (lineNum == 18) {
+          procedural = (stoi(line.substr(21)) != 0);
+        } else if (lineNum == 21) {
+          faceTextures = (stoi(line.substr(15)) != 0);
+        } else if (lineNum == 24) {
+          movesPerSecond = stof(line.substr(18));
+        } else if (lineNum == 27) {
+          parallelTurns = (stoi(line.substr(16)) != 0);
         }
         lineNum++;
       }
@@ -124,7 +279,8 @@ bool LoadSettings(int& cubeSize, int& winHeight,
     settingsFile.close();
   }
 
-  if (cubeSize > 0 && winHeight > 0 && winWidth > 0 && mouseSens > 0) {
+  if (cubeSize > 0 && winHeight > 0 && winWidth > 0 && mouseSens > 0 &&
+      movesPerSecond > 0) {
     return true;
   } else {
     return false;
@@ -132,7 +288,8 @@ bool LoadSettings(int& cubeSize, int& winHeight,
 }
 
 void ProcessInput(bool& quit, bool& rightClick, Camera& camera,
-                  Cube& cube, float& mouseSens) {
+                  Cube& cube, float& mouseSens,
+                  std::future<void>& solverLoaded) {
   SDL_Event event;
   while (SDL_PollEvent(&event)) {
     switch (event.type) {
@@ -146,6 +303,18 @@ void ProcessInput(bool& quit, bool& rightClick, Camera& camera,
             cube.SetRandRotation();
             break;
           }
+          case (SDLK_s): {
+            if (!cube.IsRotating() && cube.GetQueueDepth() == 0) {
+              QueueSolution(cube, solverLoaded);
+            }
+            break;
+          }
+          case (SDLK_p): {
+            // Cycle between animated, turbo and instant playback.
+            cube.SetPlayback(static_cast<Cube::Playback>(
+              (cube.GetPlayback() + 1) % (Cube::INSTANT + 1)));
+            break;
+          }
           case (SDLK_PERIOD): {
             cube.SetRotation(Y, cube.GetSelected().y, true);
             break;
@@ -182,6 +351,9 @@ void ProcessInput(bool& quit, bool& rightClick, Camera& camera,
                sinf(camera.GetVert()) < (PI / 4.0f))) {
             camera.GetVert() += (event.motion.yrel * mouseSens);
           }
+        } else {
+          glm::vec3 delta = camera.GetPickRay(event.motion.x, event.motion.y);
+          cube.HoverBlock(camera.GetPos(), delta);
         }
         break;
       }
@@ -203,3 +375,98 @@ void ProcessInput(bool& quit, bool& rightClick, Camera& camera,
     }
   }
 }
+
+void QueueSolution(Cube& cube, std::future<void>& solverLoaded) {
+  const CubeState& state = cube.GetState();
+  if (state.GetSize() != 3) {
+    std::cerr << "Solving is only supported for a cube of size 3"
+              << std::endl;
+    return;
+  }
+  if (solverLoaded.wait_for(std::chrono::seconds(0)) !=
+      std::future_status::ready) {
+    std::cerr << "The solver is still loading, try again shortly"
+              << std::endl;
+    return;
+  }
+
+  std::vector<FaceTurn> solution;
+  if (!TwoPhaseSolver::Get().Solve(state, solution)) {
+    std::cerr << "Failed to solve cube" << std::endl;
+    return;
+  }
+
+  // The cube animates quarter turns only, so half turns are queued twice.
+  for (size_t i = 0; i < solution.size(); i++) {
+    Move move = FaceTurnMove(solution[i], 3);
+    Dim axis = static_cast<Dim>(move.axis);
+    if (move.turns == 2) {
+      cube.SetRotation(axis, move.slice, true);
+    }
+    cube.SetRotation(axis, move.slice, move.turns != 3);
+  }
+}
+
+bool ReadNumberArg(const char* arg, int& number) {
+  char* end;
+  errno = 0;
+  long value = strtol(arg, &end, 10);
+  if (end == arg || *end != '\0' || errno == ERANGE || value < INT_MIN ||
+      value > INT_MAX) {
+    return false;
+  }
+  number = static_cast<int>(value);
+  return true;
+}
+
+int RunBenchmark(int numCubes, int scrambleLength, bool deterministic) {
+  if (numCubes < 1 || scrambleLength < 0) {
+    std::cerr << "Invalid number of cubes or scramble length" << std::endl;
+    return 1;
+  }
+
+  OptimalSolver solver(7, 0, deterministic);
+  if (!solver.Load()) {
+    std::cerr << "Failed to load pattern databases" << std::endl;
+    return 1;
+  }
+
+  srand(time(NULL));
+  std::vector<CubieCube> cubes(numCubes);
+  for (int i = 0; i < numCubes; i++) {
+    for (int j = 0; j < scrambleLength; j++) {
+      cubes[i].Multiply(CubieCube::Turn(
+        static_cast<FaceTurn>(rand() % NUM_FACE_TURNS)));
+    }
+  }
+  solver.Benchmark(cubes);
+  return 0;
+}
+
+int RunScramble(int size, int numMoves) {
+  if (size < 1 || size > UINT16_MAX || numMoves < 0) {
+    std::cerr << "Invalid cube size or number of moves" << std::endl;
+    return 1;
+  }
+
+  CubeState state(size);
+  srand(time(NULL));
+  std::vector<Move> moves(numMoves);
+  for (int i = 0; i < numMoves; i++) {
+    moves[i] = Move(static_cast<Dim>(rand() % 3), rand() % size,
+                    rand() % 3 + 1);
+  }
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  state.Apply(moves.empty() ? NULL : &moves[0], moves.size());
+  double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  state.Flush();
+
+  std::cout << numMoves << " moves on a " << size << "x" << size << "x"
+            << size << " cube in " << seconds << " s ("
+            << numMoves / seconds << " moves/s), "
+            << state.GetFacelets().size() << " bytes of stickers" << std::endl;
+  return 0;
+}
@@ -7,8 +7,10 @@
  * This file contains the implementation of an OpenGL shader.
  */
 
+#include <stdlib.h>
 #include <fstream>
 #include <iostream>
+#include <vector>
 #include "../include/shader.h"
 
 static void CheckShaderError(GLuint shader, GLuint flag, bool isProgram,
@@ -30,6 +32,15 @@ Shader::Shader(const std::string& fileName) {
   glBindAttribLocation(m_program, 0, "position");
   glBindAttribLocation(m_program, 1, "texCoord");
   glBindAttribLocation(m_program, 2, "normal");
+  // Per-instance attributes, see MeshInstances.
+  glBindAttribLocation(m_program, 3, "orientation");
+  glBindAttribLocation(m_program, 4, "texIndex");
+  glBindAttribLocation(m_program, 5, "scale");
+  glBindAttribLocation(m_program, 6, "faceColors0");
+  glBindAttribLocation(m_program, 7, "faceColors1");
+  glBindAttribLocation(m_program, 8, "posX");
+  glBindAttribLocation(m_program, 9, "posY");
+  glBindAttribLocation(m_program, 10, "posZ");
 
   glLinkProgram(m_program);
   CheckShaderError(m_program, GL_LINK_STATUS, true,
@@ -39,6 +50,21 @@ Shader::Shader(const std::string& fileName) {
                    "Error: Program is invalid: ");
 
   m_uniforms[TRANSFORM_U] = glGetUniformLocation(m_program, "transform");
+  m_uniforms[VIEWPROJECTION_U] = glGetUniformLocation(m_program,
+                                                      "viewProjection");
+  m_uniforms[SLICEAXIS_U] = glGetUniformLocation(m_program, "sliceAxis");
+  m_uniforms[SLICEPOS_U] = glGetUniformLocation(m_program, "slicePos");
+  m_uniforms[SLICEANGLE_U] = glGetUniformLocation(m_program, "sliceAngle");
+  m_uniforms[LAYER_U] = glGetUniformLocation(m_program, "layer");
+  m_uniforms[FACECOLORS0_U] = glGetUniformLocation(m_program, "faceColors0");
+  m_uniforms[FACECOLORS1_U] = glGetUniformLocation(m_program, "faceColors1");
+  m_uniforms[PALETTE_U] = glGetUniformLocation(m_program, "palette");
+  m_uniforms[BOXMIN_U] = glGetUniformLocation(m_program, "boxMin");
+  m_uniforms[BOXMAX_U] = glGetUniformLocation(m_program, "boxMax");
+  m_uniforms[SELECTED_U] = glGetUniformLocation(m_program, "selected");
+  m_uniforms[HOVERED_U] = glGetUniformLocation(m_program, "hovered");
+  m_uniforms[ORIENTATIONS_U] = glGetUniformLocation(m_program,
+                                                    "orientations");
 }
 
 void Shader::Bind() {
@@ -50,6 +76,51 @@ void Shader::Update(const Transform& transform, const Camera& camera) {
   glUniformMatrix4fv(m_uniforms[TRANSFORM_U], 1, GL_FALSE, &model[0][0]);
 }
 
+void Shader::Update(const Camera& camera) {
+  glm::mat4 viewProjection = camera.GetViewProjection();
+  glUniformMatrix4fv(m_uniforms[VIEWPROJECTION_U], 1, GL_FALSE,
+                     &viewProjection[0][0]);
+}
+
+void Shader::UpdateSlices(const glm::vec3& axis, const float* positions,
+                          const float* angles, int numSlices) {
+  glUniform3f(m_uniforms[SLICEAXIS_U], axis.x, axis.y, axis.z);
+  glUniform1fv(m_uniforms[SLICEPOS_U], numSlices, positions);
+  glUniform1fv(m_uniforms[SLICEANGLE_U], numSlices, angles);
+}
+
+void Shader::UpdateLayer(int layer) {
+  glUniform1f(m_uniforms[LAYER_U], static_cast<float>(layer));
+}
+
+void Shader::UpdateFaceColors(const uint8_t* faceColors) {
+  glUniform3f(m_uniforms[FACECOLORS0_U], faceColors[0], faceColors[1],
+              faceColors[2]);
+  glUniform3f(m_uniforms[FACECOLORS1_U], faceColors[3], faceColors[4],
+              faceColors[5]);
+}
+
+void Shader::UpdatePalette(const glm::vec3* colors, int numColors) {
+  glUniform3fv(m_uniforms[PALETTE_U], numColors, &colors[0].x);
+}
+
+void Shader::UpdateOrientations(const glm::mat4* matrices,
+                                int numMatrices) {
+  glUniformMatrix4fv(m_uniforms[ORIENTATIONS_U], numMatrices, GL_FALSE,
+                     &matrices[0][0][0]);
+}
+
+void Shader::UpdateBox(const glm::vec3& min, const glm::vec3& max) {
+  glUniform3f(m_uniforms[BOXMIN_U], min.x, min.y, min.z);
+  glUniform3f(m_uniforms[BOXMAX_U], max.x, max.y, max.z);
+}
+
+void Shader::UpdateHighlight(const glm::vec3& selected,
+                             const glm::vec3& hovered) {
+  glUniform3f(m_uniforms[SELECTED_U], selected.x, selected.y, selected.z);
+  glUniform3f(m_uniforms[HOVERED_U], hovered.x, hovered.y, hovered.z);
+}
+
 Shader::~Shader() {
   for (unsigned int i = 0; i < NUM_SHADERS; i++) {
     glDetachShader(m_program, m_shaders[i]);
@@ -90,27 +161,85 @@ static GLuint CreateShader(const std::string& text, GLenum shaderType) {
 }
 
 /**
- * Load text of a shader program.
+ * Read the lines of a shader file.
  *
- * @param fileName the shader program to load.
- * @return the text of the specified file.
+ * @param fileName The file to read.
+ * @param lines The lines of the file (to be set).
+ * @return True if the file was read, otherwise false.
  */
-static std::string LoadShader(const std::string& fileName) {
+static bool ReadShaderLines(const std::string& fileName,
+                            std::vector<std::string>& lines) {
   std::ifstream file;
   file.open((fileName).c_str());
+  if (!file.is_open()) {
+    std::cerr << "Unable to load shader: " << fileName << std::endl;
+    return false;
+  }
 
-  std::string output;
   std::string line;
+  while (file.good()) {
+    getline(file, line);
+    lines.push_back(line);
+  }
+  return true;
+}
 
-  if (file.is_open()) {
-    while (file.good()) {
-      getline(file, line);
+/**
+ * Make a directive numbering the lines that follow it.
+ *
+ * @param line Number of the next line.
+ * @param source Number of the file the next line is from, 0 for the shader
+ *    itself.
+ * @param version GLSL version of the shader.
+ * @return The directive.
+ */
+static std::string LineDirective(int line, int source, int version) {
+  // Before GLSL 3.30, #line gives the number of the line before the next.
+  return "#line " + std::to_string(version < 330 ? line - 1 : line) + " " +
+         std::to_string(source) + "\n";
+}
+
+/**
+ * Load text of a shader program. A line '#include "name"' is replaced by the
+ *    lines of the file of that name in the same directory, which may not
+ *    include other files. Compile errors give the line within each file,
+ *    preceded by 0 for the shader itself or 1 onward for each included file
+ *    in turn.
+ *
+ * @param fileName the shader program to load.
+ * @return the text of the specified file.
+ */
+static std::string LoadShader(const std::string& fileName) {
+  std::vector<std::string> lines;
+  if (!ReadShaderLines(fileName, lines)) {
+    return "";
+  }
+
+  std::string directory = fileName.substr(0, fileName.rfind('/') + 1);
+  std::string output;
+  int version = 0;
+  int numIncluded = 0;
+  for (size_t i = 0; i < lines.size(); i++) {
+    const std::string& line = lines[i];
+    if (i == 0 && line.compare(0, 8, "#version") == 0) {
+      // Definitions follow the version, which must come first.
+      version = atoi(line.c_str() + 8);
+      output.append(line + "\n#define MAX_SLICES " +
+                    std::to_string(Shader::MAX_SLICES) + "\n" +
+                    LineDirective(2, 0, version));
+    } else if (line.compare(0, 10, "#include \"") == 0) {
+      std::string name = line.substr(10, line.find('"', 10) - 10);
+      std::vector<std::string> included;
+      ReadShaderLines(directory + name, included);
+      output.append(LineDirective(1, ++numIncluded, version));
+      for (size_t j = 0; j < included.size(); j++) {
+        output.append(included[j] + "\n");
+      }
+      output.append(LineDirective(i + 2, 0, version));
+    } else {
       output.append(line + "\n");
     }
-  } else {
-    std::cerr << "Unable to load shader: " << fileName << std::endl;
   }
-
   return output;
 }
 
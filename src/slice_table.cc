@@ -0,0 +1,145 @@
+/**
+ * @file slice_table.cc
+ * @author Charles Ian Mclees
+ *  
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of precomputed index permutations
+ * for every slice turn of a cube of a given size.
+ */
+
+#include <map>
+#include <mutex>
+#include "../include/slice_table.h"
+
+const SliceTable& SliceTable::ForSize(int size) {
+  static std::mutex mutex;
+  static std::map<int, SliceTable*> tables;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  SliceTable*& table = tables[size];
+  if (table == NULL) {
+    table = new SliceTable(size);
+  }
+  return *table;
+}
+
+SliceTable::SliceTable(int size) :
+  m_size(size),
+  m_faceletStart(3 * size + 1),
+  m_surfaceStart(3 * size + 1) {
+  int last = size - 1;
+  int p0[3], p1[3], p2[3], p3[3];
+
+  for (int a = 0; a < 3; a++) {
+    // Axes b and c follow a cyclically, so that a clockwise quarter turn
+    // about a carries +b to +c, +c to -b, -b to -c and -c to +b.
+    int b = (a + 1) % 3;
+    int c = (a + 2) % 3;
+
+    for (int s = 0; s < size; s++) {
+      m_faceletStart[a * size + s] = m_faceletCycles.size();
+      p0[a] = p1[a] = p2[a] = p3[a] = s;
+
+      // Facelets on the four faces around the slab.
+      for (int t = 0; t < size; t++) {
+        p0[b] = last;      p0[c] = t;
+        p1[b] = last - t;  p1[c] = last;
+        p2[b] = 0;         p2[c] = last - t;
+        p3[b] = t;         p3[c] = 0;
+        m_faceletCycles.push_back(FaceletIndex(b, true, p0));
+        m_faceletCycles.push_back(FaceletIndex(c, true, p1));
+        m_faceletCycles.push_back(FaceletIndex(b, false, p2));
+        m_faceletCycles.push_back(FaceletIndex(c, false, p3));
+      }
+
+      // Outer slabs also turn the face on their side of the cube.
+      if (s == 0 || s == last) {
+        bool positive = (s == last);
+        for (int i = 0; i < size / 2; i++) {
+          for (int j = 0; j < (size + 1) / 2; j++) {
+            p0[b] = i;         p0[c] = j;
+            p1[b] = last - j;  p1[c] = i;
+            p2[b] = last - i;  p2[c] = last - j;
+            p3[b] = j;         p3[c] = last - i;
+            m_faceletCycles.push_back(FaceletIndex(a, positive, p0));
+            m_faceletCycles.push_back(FaceletIndex(a, positive, p1));
+            m_faceletCycles.push_back(FaceletIndex(a, positive, p2));
+            m_faceletCycles.push_back(FaceletIndex(a, positive, p3));
+          }
+        }
+      }
+    }
+  }
+  m_faceletStart[3 * size] = m_faceletCycles.size();
+
+  // Every block of a slab turns the same way as the facelets of an outer
+  // face, including the center block of odd sizes which stays in place.
+  m_blockStride[X] = size * size;
+  m_blockStride[Y] = size;
+  m_blockStride[Z] = 1;
+  for (int a = 0; a < 3; a++) {
+    size_t strideB = m_blockStride[(a + 1) % 3];
+    size_t strideC = m_blockStride[(a + 2) % 3];
+
+    m_blockStart[a] = m_blockCycles.size();
+    for (int i = 0; i < size / 2; i++) {
+      for (int j = 0; j < (size + 1) / 2; j++) {
+        m_blockCycles.push_back(i * strideB + j * strideC);
+        m_blockCycles.push_back((last - j) * strideB + i * strideC);
+        m_blockCycles.push_back((last - i) * strideB + (last - j) * strideC);
+        m_blockCycles.push_back(j * strideB + (last - i) * strideC);
+      }
+    }
+  }
+  m_blockStart[3] = m_blockCycles.size();
+
+  // Surface blocks turn as facelets do: an inner slab turns only its ring,
+  // and an outer slab all of its blocks.
+  for (int a = 0; a < 3; a++) {
+    int b = (a + 1) % 3;
+    int c = (a + 2) % 3;
+
+    for (int s = 0; s < size; s++) {
+      m_surfaceStart[a * size + s] = m_surfaceCycles.size();
+      p0[a] = p1[a] = p2[a] = p3[a] = s;
+
+      if (s == 0 || s == last) {
+        for (int i = 0; i < size / 2; i++) {
+          for (int j = 0; j < (size + 1) / 2; j++) {
+            p0[b] = i;         p0[c] = j;
+            p1[b] = last - j;  p1[c] = i;
+            p2[b] = last - i;  p2[c] = last - j;
+            p3[b] = j;         p3[c] = last - i;
+            m_surfaceCycles.push_back(SurfaceIndex(p0));
+            m_surfaceCycles.push_back(SurfaceIndex(p1));
+            m_surfaceCycles.push_back(SurfaceIndex(p2));
+            m_surfaceCycles.push_back(SurfaceIndex(p3));
+          }
+        }
+      } else {
+        for (int t = 0; t < last; t++) {
+          p0[b] = t;         p0[c] = 0;
+          p1[b] = last;      p1[c] = t;
+          p2[b] = last - t;  p2[c] = last;
+          p3[b] = 0;         p3[c] = last - t;
+          m_surfaceCycles.push_back(SurfaceIndex(p0));
+          m_surfaceCycles.push_back(SurfaceIndex(p1));
+          m_surfaceCycles.push_back(SurfaceIndex(p2));
+          m_surfaceCycles.push_back(SurfaceIndex(p3));
+        }
+      }
+    }
+  }
+  m_surfaceStart[3 * size] = m_surfaceCycles.size();
+}
+
+uint32_t SliceTable::FaceletIndex(int axis, bool positive,
+                                  const int cell[3]) const {
+  // Facelet coordinates are the block position along the remaining axes, in
+  // X, Y, Z order.
+  int face = axis * 2 + (positive ? 1 : 0);
+  int u = cell[axis == X ? Y : X];
+  int v = cell[axis == Z ? Y : Z];
+  return (face * m_size + u) * m_size + v;
+}
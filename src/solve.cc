@@ -0,0 +1,81 @@
+/**
+ * @file solve.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the main function for a command line tool which solves
+ * 3x3 cubes in bulk, without opening a window.
+ */
+
+#include <stdlib.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "../include/batch_solver.h"
+
+/**
+ * Function to print how to run the tool.
+ */
+void PrintUsage();
+
+/**
+ * Main function to solve every cube in a file, or in standard input if no
+ * file is given, writing one solution per line to standard output.
+ */
+int main(int argc, char* argv[]) {
+  bool optimal = false;
+  int numThreads = 0;
+  std::string path = "-";
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--optimal") {
+      optimal = true;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      numThreads = atoi(argv[++i]);
+    } else if (arg[0] == '-' && arg != "-") {
+      PrintUsage();
+      return 1;
+    } else {
+      path = arg;
+    }
+  }
+
+  std::ifstream file;
+  if (path != "-") {
+    file.open(path.c_str());
+    if (!file.is_open()) {
+      std::cerr << "Failed to open \"" << path << "\"" << std::endl;
+      return 1;
+    }
+  }
+  std::istream& input = (path != "-") ? file : std::cin;
+
+  // Solutions go to standard output, so the report goes to standard error.
+  std::ios::sync_with_stdio(false);
+  bool solved;
+  if (optimal) {
+    OptimalSolver solver(7, 1);
+    if (!solver.Load()) {
+      std::cerr << "Failed to load pattern databases" << std::endl;
+      return 1;
+    }
+    solved = BatchSolver(solver, numThreads).Run(input, std::cout,
+                                                 std::cerr);
+  } else {
+    solved = BatchSolver(TwoPhaseSolver::Get(), numThreads).Run(
+      input, std::cout, std::cerr);
+  }
+  return solved ? 0 : 2;
+}
+
+void PrintUsage() {
+  std::cerr << "Usage: solve [--optimal] [--threads N] [file]" << std::endl
+            << std::endl
+            << "Each line of the file (or of standard input) holds a cube:"
+            << std::endl
+            << "  face turns scrambling a solved cube, such as \"R U2 F'\", or"
+            << std::endl
+            << "  54 facelet letters (LRDUBF), face by face." << std::endl
+            << "One solution is written per cube, in input order." << std::endl;
+}
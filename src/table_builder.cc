@@ -0,0 +1,176 @@
+/**
+ * @file table_builder.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of a multi-threaded builder of solver
+ * pruning tables.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "../include/table_builder.h"
+
+// Entry not yet reached by the search. Reaching an entry only clears bits,
+// so it can be done with an atomic and.
+static const int UNVISITED = 0xF;
+
+// Entries claimed by a thread at a time. Even, so that no byte is shared
+// between two chunks.
+static const uint64_t CHUNK_SIZE = 1 << 16;
+
+/**
+ * Read an entry which other threads may be writing.
+ */
+static inline int LoadEntry(const uint8_t* table, uint64_t index) {
+  uint8_t byte = __atomic_load_n(&table[index >> 1], __ATOMIC_RELAXED);
+  return (byte >> ((index & 1) << 2)) & 0xF;
+}
+
+/**
+ * Set an unreached entry which other threads may also be setting.
+ *
+ * @return True if this call reached the entry, false if it already had been.
+ */
+static inline bool ReachEntry(uint8_t* table, uint64_t index, int value) {
+  int shift = (index & 1) << 2;
+  uint8_t mask = ~((UNVISITED ^ value) << shift);
+  uint8_t old = __atomic_fetch_and(&table[index >> 1], mask,
+                                   __ATOMIC_RELAXED);
+  return ((old >> shift) & 0xF) == UNVISITED;
+}
+
+TableBuilder::TableBuilder(int numThreads, bool report) {
+  m_numThreads = numThreads;
+  if (m_numThreads <= 0) {
+    m_numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_report = report;
+}
+
+void TableBuilder::Build(const PruneSpace& space,
+                         std::vector<uint8_t>& table) const {
+  uint64_t size = space.GetSize();
+  table.assign((size + 1) / 2, 0xFF);
+  PatternDatabase::Set(&table[0], space.GetGoal(), 0);
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  uint64_t frontier = 1;
+  uint64_t unvisited = size - 1;
+  for (int depth = 0; frontier > 0 && depth < UNVISITED - 1; depth++) {
+    std::chrono::steady_clock::time_point layerStart =
+      std::chrono::steady_clock::now();
+
+    // Expanding the frontier costs a lookup per neighbor of each frontier
+    // entry, and checking unreached entries a lookup per neighbor until one
+    // is found in the frontier, so search from whichever side is smaller.
+    bool backward = unvisited < frontier;
+    std::atomic<uint64_t> nextChunk(0);
+    std::vector<uint64_t> reached(m_numThreads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 1; t < m_numThreads; t++) {
+      threads.push_back(std::thread(SearchLayer, &space, &table[0], depth,
+                                    backward, &nextChunk, &reached[t]));
+    }
+    SearchLayer(&space, &table[0], depth, backward, &nextChunk, &reached[0]);
+    for (size_t t = 0; t < threads.size(); t++) {
+      threads[t].join();
+    }
+
+    frontier = 0;
+    for (int t = 0; t < m_numThreads; t++) {
+      frontier += reached[t];
+    }
+    unvisited -= frontier;
+
+    if (m_report) {
+      double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - layerStart).count();
+      std::cerr << "  depth " << std::setw(2) << depth + 1 << ": "
+                << std::setw(10) << frontier << " entries "
+                << (backward ? "(backward) " : "(forward)  ")
+                << std::fixed << std::setprecision(3) << seconds << " s, "
+                << std::setprecision(1)
+                << size / seconds / 1000000.0 << " M entries/s"
+                << std::endl;
+    }
+  }
+
+  if (m_report) {
+    double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+    std::cerr << "  " << size << " entries in " << std::fixed
+              << std::setprecision(3) << seconds << " s on " << m_numThreads
+              << " threads" << std::endl;
+  }
+}
+
+void TableBuilder::SearchLayer(const PruneSpace* space, uint8_t* table,
+                               int depth, bool backward,
+                               std::atomic<uint64_t>* nextChunk,
+                               uint64_t* reached) {
+  uint64_t size = space->GetSize();
+  uint64_t neighbors[PruneSpace::MAX_NEIGHBORS];
+  uint64_t count = 0;
+
+  for (;;) {
+    uint64_t begin = nextChunk->fetch_add(CHUNK_SIZE);
+    if (begin >= size) {
+      break;
+    }
+    uint64_t end = std::min(begin + CHUNK_SIZE, size);
+
+    for (uint64_t index = begin; index < end; index++) {
+      int entry = LoadEntry(table, index);
+      if (backward) {
+        if (entry != UNVISITED) {
+          continue;
+        }
+        int n = space->GetNeighbors(index, neighbors);
+        for (int i = 0; i < n; i++) {
+          if (LoadEntry(table, neighbors[i]) == depth) {
+            ReachEntry(table, index, depth + 1);
+            count++;
+            break;
+          }
+        }
+      } else {
+        if (entry != depth) {
+          continue;
+        }
+        int n = space->GetNeighbors(index, neighbors);
+        for (int i = 0; i < n; i++) {
+          if (LoadEntry(table, neighbors[i]) == UNVISITED &&
+              ReachEntry(table, neighbors[i], depth + 1)) {
+            count++;
+          }
+        }
+      }
+    }
+  }
+  *reached = count;
+}
+
+void TableBuilder::LoadOrBuild(const PruneSpace& space,
+                               const std::string& path, uint32_t pattern,
+                               PatternDatabase& database, bool verify) const {
+  if (database.Open(path, pattern, space.GetSize(), verify)) {
+    return;
+  }
+
+  if (m_report) {
+    std::cerr << "Building pruning table \"" << path << "\" ("
+              << space.GetSize() << " entries)" << std::endl;
+  }
+  std::vector<uint8_t> table;
+  Build(space, table);
+  if (!PatternDatabase::Write(path, pattern, table, space.GetSize()) ||
+      !database.Open(path, pattern, space.GetSize(), false)) {
+    database.Adopt(table);
+  }
+}
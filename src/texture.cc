@@ -14,10 +14,20 @@
 
 Texture::Texture(int numTextures, const std::string fileNames[]) {
   m_numTextures = numTextures;
-  m_textures = new GLuint[m_numTextures];
 
-  glGenTextures(numTextures, m_textures);
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
 
+  // Texture wrap setting
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  // Texture magnification setting. Distant blocks sample the mipmaps.
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  int arrayWidth = 0, arrayHeight = 0;
   for (int i = 0; i < m_numTextures; i++) {
     // Load texture from file using stb_image library
     int width, height, numComponents;
@@ -26,38 +36,43 @@ Texture::Texture(int numTextures, const std::string fileNames[]) {
     if (imageData == NULL) {
       std::cerr << "Texture loading failed for texture: " << fileNames[i]
                 << std::endl;
+      continue;
     }
 
-    glBindTexture(GL_TEXTURE_2D, m_textures[i]);
-
-    // Texture wrap setting
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    // Texture magnification setting
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Size the array from the first layer.
+    if (arrayWidth == 0) {
+      arrayWidth = width;
+      arrayHeight = height;
+      glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height,
+                   m_numTextures, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
 
-    // Send texture to GPU (load in GL)
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE, imageData);
+    // Send layer to GPU
+    if (width == arrayWidth && height == arrayHeight) {
+      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1,
+                      GL_RGBA, GL_UNSIGNED_BYTE, imageData);
+    } else {
+      std::cerr << "Texture size mismatch for texture array layer: "
+                << fileNames[i] << std::endl;
+    }
 
     // Free texture from main memory
     stbi_image_free(imageData);
   }
+
+  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 }
 
-void Texture::Bind(unsigned int unit, int texture) {
+void Texture::Bind(unsigned int unit) {
   assert(unit >= 0 && unit <= 31);
-  assert(texture >= 0 && texture < m_numTextures);
 
   // Choose active texture
   glActiveTexture(GL_TEXTURE0 + unit);
-  glBindTexture(GL_TEXTURE_2D, m_textures[texture]);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
 }
 
 Texture::~Texture() {
   // Delete texture from GPU memory
-  glDeleteTextures(m_numTextures, m_textures);
-  delete [] m_textures;
+  glDeleteTextures(1, &m_texture);
 }
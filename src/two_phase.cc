@@ -0,0 +1,376 @@
+/**
+ * @file two_phase.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains the implementation of Kociemba's two-phase solver for
+ * the 3x3 cube.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "../include/two_phase.h"
+#include "../include/slice_table.h"
+#include "../include/table_builder.h"
+
+// Face turns of phase one and phase two. Turns of the same face are
+// adjacent, and the face is turn / 3 in phase one.
+static const FaceTurn PHASE1_MOVES[NUM_FACE_TURNS] = {
+  TURN_U1, TURN_U2, TURN_U3, TURN_R1, TURN_R2, TURN_R3,
+  TURN_F1, TURN_F2, TURN_F3, TURN_D1, TURN_D2, TURN_D3,
+  TURN_L1, TURN_L2, TURN_L3, TURN_B1, TURN_B2, TURN_B3
+};
+static const int NUM_PHASE2_MOVES = 10;
+static const FaceTurn PHASE2_MOVES[NUM_PHASE2_MOVES] = {
+  TURN_U1, TURN_U2, TURN_U3, TURN_D1, TURN_D2, TURN_D3,
+  TURN_R2, TURN_F2, TURN_L2, TURN_B2
+};
+
+// Longest solution searched for in each phase. Every phase two position is
+// within 18 moves, but longer phase two searches rarely pay off compared
+// with trying the next phase one solution.
+static const int MAX_PHASE1_LENGTH = 20;
+static const int MAX_PHASE2_LENGTH = 12;
+
+// Nodes visited between checks of the clock.
+static const int TIMEOUT_CHECK_NODES = 4096;
+
+/**
+ * Check whether a face turn keeps a cube within the phase two subgroup.
+ */
+static inline bool IsPhase2Turn(int turn) {
+  int face = TurnFace(turn);
+  return face == 0 || face == 3 || turn % 3 == 1;
+}
+
+// The cube is searched in three orientations, each with phase one's U and D
+// faces on a different axis, and each both as given and inverted. Whichever
+// variant finds a short solution first ends the search.
+static const int NUM_ORIENTATIONS = 3;
+static const int NUM_VARIANTS = NUM_ORIENTATIONS * 2;
+
+// Faces in FaceTurn order.
+static const Face TURN_FACES[6] = {
+  FACE_U, FACE_R, FACE_F, FACE_D, FACE_L, FACE_B
+};
+
+/**
+ * Turn a whole cube a third of a turn about the diagonal through its UBR
+ * corner, carrying the U face to R, R to B and B to U.
+ *
+ * @param cube The cube.
+ */
+static void RotateUBR(Cube3& cube) {
+  const SliceTable& table = SliceTable::ForSize(3);
+  for (int slice = 0; slice < 3; slice++) {
+    table.TurnFacelets(cube.facelets, Move(X, slice, 1));
+  }
+  for (int slice = 0; slice < 3; slice++) {
+    table.TurnFacelets(cube.facelets, Move(Y, slice, 1));
+  }
+}
+
+struct TwoPhaseSolver::Search {
+  CubieCube cubes[NUM_VARIANTS];
+  int turnMap[NUM_VARIANTS][NUM_FACE_TURNS];  // Variant turn to cube turn.
+  int variant;      // Variant being searched.
+  uint8_t moves[MAX_PHASE1_LENGTH + MAX_PHASE2_LENGTH];
+  int maxLength;    // Longest solution still worth finding.
+  int goalLength;   // Stop at a solution at most this long.
+  uint8_t best[MAX_PHASE1_LENGTH + MAX_PHASE2_LENGTH];
+  int bestLength;   // -1 until a solution is found.
+  uint64_t nodes;
+  uint64_t maxNodes;  // Nodes to search before stopping, 0 for no limit.
+  bool timed;         // True if the search stops at the deadline.
+  std::chrono::steady_clock::time_point deadline;
+};
+
+/**
+ * A pair of coordinates, searched to build a pruning table.
+ */
+class TwoPhaseSolver::PairSpace : public PruneSpace {
+  public:
+    PairSpace(const std::vector<uint16_t>& moveA, int sizeA,
+              const std::vector<uint16_t>& moveB, int sizeB, int numMoves)
+      : m_moveA(moveA), m_sizeA(sizeA), m_moveB(moveB), m_sizeB(sizeB),
+        m_numMoves(numMoves) {}
+
+    uint64_t GetSize() const {
+      return static_cast<uint64_t>(m_sizeA) * m_sizeB;
+    }
+
+    uint64_t GetGoal() const {
+      return 0;
+    }
+
+    int GetNeighbors(uint64_t index, uint64_t* neighbors) const {
+      int a = index / m_sizeB;
+      int b = index % m_sizeB;
+      for (int m = 0; m < m_numMoves; m++) {
+        neighbors[m] = m_moveA[a * m_numMoves + m] * m_sizeB +
+                       m_moveB[b * m_numMoves + m];
+      }
+      return m_numMoves;
+    }
+  protected:
+  private:
+    const std::vector<uint16_t>& m_moveA;
+    int m_sizeA;
+    const std::vector<uint16_t>& m_moveB;
+    int m_sizeB;
+    int m_numMoves;
+};
+
+const TwoPhaseSolver& TwoPhaseSolver::Get() {
+  static const TwoPhaseSolver solver("./data/table");
+  return solver;
+}
+
+TwoPhaseSolver::TwoPhaseSolver(const std::string& directory) {
+  BuildMoveTable(m_twistMove, NUM_TWISTS, PHASE1_MOVES, NUM_FACE_TURNS,
+                 &CubieCube::SetTwist, &CubieCube::GetTwist);
+  BuildMoveTable(m_flipMove, NUM_FLIPS, PHASE1_MOVES, NUM_FACE_TURNS,
+                 &CubieCube::SetFlip, &CubieCube::GetFlip);
+  BuildMoveTable(m_sliceMove, NUM_SLICES, PHASE1_MOVES, NUM_FACE_TURNS,
+                 &CubieCube::SetSlice, &CubieCube::GetSlice);
+  BuildMoveTable(m_cornerMove, NUM_CORNER_PERMS, PHASE2_MOVES,
+                 NUM_PHASE2_MOVES, &CubieCube::SetCornerPerm,
+                 &CubieCube::GetCornerPerm);
+  BuildMoveTable(m_edge8Move, NUM_EDGE8_PERMS, PHASE2_MOVES,
+                 NUM_PHASE2_MOVES, &CubieCube::SetEdge8Perm,
+                 &CubieCube::GetEdge8Perm);
+  BuildMoveTable(m_slicePermMove, NUM_SLICE_PERMS, PHASE2_MOVES,
+                 NUM_PHASE2_MOVES, &CubieCube::SetSlicePerm,
+                 &CubieCube::GetSlicePerm);
+
+  // The pruning tables are cached in files, as building them takes most
+  // of the time.
+  TableBuilder builder;
+  builder.LoadOrBuild(PairSpace(m_twistMove, NUM_TWISTS, m_sliceMove,
+                                NUM_SLICES, NUM_FACE_TURNS),
+                      directory + "/twist_slice.pdb", 0x30001,
+                      m_twistSlicePrune);
+  builder.LoadOrBuild(PairSpace(m_flipMove, NUM_FLIPS, m_sliceMove,
+                                NUM_SLICES, NUM_FACE_TURNS),
+                      directory + "/flip_slice.pdb", 0x30002,
+                      m_flipSlicePrune);
+  builder.LoadOrBuild(PairSpace(m_cornerMove, NUM_CORNER_PERMS,
+                                m_slicePermMove, NUM_SLICE_PERMS,
+                                NUM_PHASE2_MOVES),
+                      directory + "/corner_slice_perm.pdb", 0x30003,
+                      m_cornerSlicePrune);
+  builder.LoadOrBuild(PairSpace(m_edge8Move, NUM_EDGE8_PERMS,
+                                m_slicePermMove, NUM_SLICE_PERMS,
+                                NUM_PHASE2_MOVES),
+                      directory + "/edge_slice_perm.pdb", 0x30004,
+                      m_edgeSlicePrune);
+}
+
+void TwoPhaseSolver::BuildMoveTable(std::vector<uint16_t>& table, int size,
+                                    const FaceTurn* moves, int numMoves,
+                                    void (CubieCube::*set)(int),
+                                    int (CubieCube::*get)() const) {
+  table.resize(size * numMoves);
+  for (int coord = 0; coord < size; coord++) {
+    CubieCube cube;
+    (cube.*set)(coord);
+    for (int m = 0; m < numMoves; m++) {
+      CubieCube moved = cube;
+      moved.Multiply(CubieCube::Turn(moves[m]));
+      table[coord * numMoves + m] = (moved.*get)();
+    }
+  }
+}
+
+bool TwoPhaseSolver::Solve(const CubeState& state,
+                           std::vector<FaceTurn>& solution, int maxLength,
+                           int timeoutMs, uint64_t maxNodes) const {
+  if (state.GetSize() != 3) {
+    return false;
+  }
+  return Solve(Cube3(state), solution, maxLength, timeoutMs, maxNodes);
+}
+
+bool TwoPhaseSolver::Solve(const Cube3& cube, std::vector<FaceTurn>& solution,
+                           int maxLength, int timeoutMs,
+                           uint64_t maxNodes) const {
+  CubieCube cubies;
+  if (!CubieCube::FromFacelets(cube, cubies)) {
+    return false;
+  }
+  return Solve(cubies, solution, maxLength, timeoutMs, maxNodes);
+}
+
+bool TwoPhaseSolver::Solve(const CubieCube& cube,
+                           std::vector<FaceTurn>& solution, int maxLength,
+                           int timeoutMs, uint64_t maxNodes) const {
+  if (!cube.IsSolvable()) {
+    return false;
+  }
+
+  Search search;
+  search.maxLength = MAX_PHASE1_LENGTH + MAX_PHASE2_LENGTH - 1;
+  search.goalLength = maxLength;
+  search.bestLength = -1;
+  search.nodes = 0;
+  search.maxNodes = maxNodes;
+  search.timed = timeoutMs > 0;
+  search.deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeoutMs);
+
+  // Reading a turned cube relative to its centers conjugates it by the
+  // turn, and a face turn of the turned cube is a turn of whichever face its
+  // center came from.
+  Cube3 facelets = cube.ToFacelets();
+  Cube3 faces;
+  for (int o = 0; o < NUM_ORIENTATIONS; o++) {
+    CubieCube& turned = search.cubes[o * 2];
+    CubieCube::FromFacelets(facelets, turned);
+    search.cubes[o * 2 + 1] = turned.Inverse();
+    for (int t = 0; t < NUM_FACE_TURNS; t++) {
+      int face = 0;
+      while (TURN_FACES[face] != faces.facelets[TURN_FACES[t / 3] * 9 + 4]) {
+        face++;
+      }
+      search.turnMap[o * 2][t] = face * 3 + t % 3;
+      search.turnMap[o * 2 + 1][t] = face * 3 + t % 3;
+    }
+    RotateUBR(facelets);
+    RotateUBR(faces);
+  }
+
+  int dist[NUM_VARIANTS];
+  for (int v = 0; v < NUM_VARIANTS; v++) {
+    const CubieCube& c = search.cubes[v];
+    dist[v] = std::max(
+      m_twistSlicePrune.Get(c.GetTwist() * NUM_SLICES + c.GetSlice()),
+      m_flipSlicePrune.Get(c.GetFlip() * NUM_SLICES + c.GetSlice()));
+  }
+
+  // Iterative deepening on the length of phase one, so the shortest phase
+  // one solutions are tried first. Each solution found bounds the total
+  // length of those tried after it.
+  bool done = false;
+  for (int depth1 = 0; !done && depth1 <= std::min(search.maxLength,
+                                                   MAX_PHASE1_LENGTH);
+       depth1++) {
+    for (int v = 0; !done && v < NUM_VARIANTS; v++) {
+      if (depth1 >= dist[v]) {
+        const CubieCube& c = search.cubes[v];
+        search.variant = v;
+        done = Phase1(search, c.GetTwist(), c.GetFlip(), c.GetSlice(), 0,
+                      depth1);
+      }
+    }
+  }
+
+  solution.clear();
+  for (int i = 0; i < search.bestLength; i++) {
+    solution.push_back(static_cast<FaceTurn>(search.best[i]));
+  }
+  return search.bestLength >= 0;
+}
+
+bool TwoPhaseSolver::Phase1(Search& search, int twist, int flip, int slice,
+                            int depth, int togo) const {
+  if (togo == 0) {
+    // A solution ending in a phase two turn was already tried without it.
+    if (depth == 0 || !IsPhase2Turn(search.moves[depth - 1])) {
+      return StartPhase2(search, depth);
+    }
+    return false;
+  }
+
+  if (++search.nodes == search.maxNodes) {
+    return true;
+  }
+  if (search.timed && search.nodes % TIMEOUT_CHECK_NODES == 0 &&
+      std::chrono::steady_clock::now() > search.deadline) {
+    return true;
+  }
+
+  int lastFace = depth > 0 ? TurnFace(search.moves[depth - 1]) : -1;
+  for (int m = 0; m < NUM_FACE_TURNS; m++) {
+    if (!CanFollow(TurnFace(m), lastFace)) {
+      m += 2;
+      continue;
+    }
+    int newTwist = m_twistMove[twist * NUM_FACE_TURNS + m];
+    int newFlip = m_flipMove[flip * NUM_FACE_TURNS + m];
+    int newSlice = m_sliceMove[slice * NUM_FACE_TURNS + m];
+    int dist = std::max(
+      m_twistSlicePrune.Get(newTwist * NUM_SLICES + newSlice),
+      m_flipSlicePrune.Get(newFlip * NUM_SLICES + newSlice));
+    if (dist < togo) {
+      search.moves[depth] = m;
+      if (Phase1(search, newTwist, newFlip, newSlice, depth + 1, togo - 1)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool TwoPhaseSolver::StartPhase2(Search& search, int depth1) const {
+  CubieCube cube = search.cubes[search.variant];
+  for (int i = 0; i < depth1; i++) {
+    cube.Multiply(CubieCube::Turn(static_cast<FaceTurn>(search.moves[i])));
+  }
+  int corner = cube.GetCornerPerm();
+  int edge = cube.GetEdge8Perm();
+  int slice = cube.GetSlicePerm();
+
+  int maxDepth2 = std::min(search.maxLength - depth1, MAX_PHASE2_LENGTH);
+  int dist = std::max(
+    m_cornerSlicePrune.Get(corner * NUM_SLICE_PERMS + slice),
+    m_edgeSlicePrune.Get(edge * NUM_SLICE_PERMS + slice));
+  for (int depth2 = dist; depth2 <= maxDepth2; depth2++) {
+    if (Phase2(search, corner, edge, slice, depth1, depth2)) {
+      // Turn the solution back to the cube's orientation. The solution of
+      // an inverted cube is undone, so its turns are reversed and inverted.
+      int length = depth1 + depth2;
+      const int* turnMap = search.turnMap[search.variant];
+      for (int i = 0; i < length; i++) {
+        if (search.variant % 2 == 0) {
+          search.best[i] = turnMap[search.moves[i]];
+        } else {
+          int turn = turnMap[search.moves[length - 1 - i]];
+          search.best[i] = turn - turn % 3 + (2 - turn % 3);
+        }
+      }
+      search.bestLength = length;
+      search.maxLength = search.bestLength - 1;
+      return search.bestLength <= search.goalLength;
+    }
+  }
+  return false;
+}
+
+bool TwoPhaseSolver::Phase2(Search& search, int corner, int edge, int slice,
+                            int depth, int togo) const {
+  if (togo == 0) {
+    return corner == 0 && edge == 0 && slice == 0;
+  }
+
+  int lastFace = depth > 0 ? TurnFace(search.moves[depth - 1]) : -1;
+  for (int m = 0; m < NUM_PHASE2_MOVES; m++) {
+    int turn = PHASE2_MOVES[m];
+    if (!CanFollow(TurnFace(turn), lastFace)) {
+      continue;
+    }
+    int newCorner = m_cornerMove[corner * NUM_PHASE2_MOVES + m];
+    int newEdge = m_edge8Move[edge * NUM_PHASE2_MOVES + m];
+    int newSlice = m_slicePermMove[slice * NUM_PHASE2_MOVES + m];
+    int dist = std::max(
+      m_cornerSlicePrune.Get(newCorner * NUM_SLICE_PERMS + newSlice),
+      m_edgeSlicePrune.Get(newEdge * NUM_SLICE_PERMS + newSlice));
+    if (dist < togo) {
+      search.moves[depth] = turn;
+      if (Phase2(search, newCorner, newEdge, newSlice, depth + 1, togo - 1)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
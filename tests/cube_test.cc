@@ -0,0 +1,258 @@
+/**
+ * @file cube_test.cc
+ * @author Charles Ian Mclees
+ *
+ * @section DESCRIPTION
+ *
+ * This file contains cross-checks of the headless cube library: every way of
+ * turning a cube must agree on random sequences of moves, and every solver
+ * must solve what it is given. Run with "make test" from the top directory.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/cube3.h"
+#include "../include/cube_state.h"
+#include "../include/cubie_cube.h"
+#include "../include/notation.h"
+#include "../include/optimal_solver.h"
+#include "../include/permutation.h"
+#include "../include/two_phase.h"
+
+static int numChecks = 0;
+static int numFailed = 0;
+
+/**
+ * Count a check, reporting it if it failed.
+ *
+ * @param passed True if the check passed.
+ * @param what What was checked.
+ */
+static void Check(bool passed, const std::string& what) {
+  numChecks++;
+  if (!passed) {
+    numFailed++;
+    std::cerr << "FAILED: " << what << std::endl;
+  }
+}
+
+/**
+ * Make random face turns.
+ *
+ * @param numTurns The number of face turns.
+ * @return The face turns.
+ */
+static std::vector<FaceTurn> RandomTurns(int numTurns) {
+  std::vector<FaceTurn> turns(numTurns);
+  for (int i = 0; i < numTurns; i++) {
+    turns[i] = static_cast<FaceTurn>(rand() % NUM_FACE_TURNS);
+  }
+  return turns;
+}
+
+/**
+ * Turn a solved cube by face turns, one slice move at a time.
+ *
+ * @param turns The face turns.
+ * @return The cube.
+ */
+static CubeState TurnedState(const std::vector<FaceTurn>& turns) {
+  CubeState state(3);
+  for (size_t i = 0; i < turns.size(); i++) {
+    state.Apply(FaceTurnMove(turns[i], 3));
+  }
+  return state;
+}
+
+/**
+ * Check that single moves, move sequences and composed permutations turn
+ * cubes of many sizes alike.
+ */
+static void CheckStateAndPermutation() {
+  for (int size = 1; size <= 9; size++) {
+    std::vector<Move> moves(300);
+    for (size_t i = 0; i < moves.size(); i++) {
+      moves[i] = Move(static_cast<Dim>(rand() % 3), rand() % size,
+                      rand() % 4);
+    }
+    CubeState single(size), sequence(size), composed(size);
+    for (size_t i = 0; i < moves.size(); i++) {
+      single.Apply(moves[i]);
+    }
+    sequence.Apply(&moves[0], moves.size());
+    Permutation permutation(size, &moves[0], moves.size());
+    composed.Apply(permutation);
+    std::string name = "size " + std::to_string(size);
+    Check(single == sequence, name + ": move sequence matches single moves");
+    Check(single == composed, name + ": permutation matches single moves");
+    Check(single.ToString() == sequence.ToString(),
+          name + ": pending and flushed turns print alike");
+
+    composed.Apply(permutation.Inverse());
+    Check(composed.IsSolved(), name + ": inverse permutation solves");
+  }
+}
+
+/**
+ * Check that every instruction set of the 3x3 move engine turns cubes as the
+ * cube state does.
+ */
+static void CheckKernels() {
+  const char* names[] = { "scalar", "ssse3", "avx2", "avx512vbmi" };
+  for (int n = 0; n < 4; n++) {
+    Cube3Kernel kernel(names[n]);
+    std::string name = kernel.GetName();
+    if (name != names[n]) {
+      std::cout << names[n] << " is not supported, checking " << name
+                << " in its place" << std::endl;
+    }
+
+    std::vector<FaceTurn> turns = RandomTurns(200);
+    std::vector<uint8_t> sequence(turns.begin(), turns.end());
+    Cube3 expected(TurnedState(turns));
+
+    Cube3 single;
+    for (size_t i = 0; i < turns.size(); i++) {
+      kernel.Apply(single, turns[i]);
+    }
+    Check(single == expected, name + ": single turns match the cube state");
+
+    Cube3 applied;
+    kernel.Apply(applied, &sequence[0], sequence.size());
+    Check(applied == expected, name + ": turn sequence matches");
+
+    Cube3 shuffled;
+    kernel.Apply(shuffled, kernel.Compose(&sequence[0], sequence.size()));
+    Check(shuffled == expected, name + ": composed shuffle matches");
+
+    std::vector<Cube3> batch(37);
+    kernel.ApplyBatch(&batch[0], batch.size(), &sequence[0],
+                      sequence.size());
+    bool same = true;
+    for (size_t i = 0; i < batch.size(); i++) {
+      same = same && batch[i] == expected;
+    }
+    Check(same, name + ": batch matches");
+  }
+}
+
+/**
+ * Check that cubie cubes turn as facelets do, and convert both ways.
+ */
+static void CheckCubieCube() {
+  for (int i = 0; i < 20; i++) {
+    std::vector<FaceTurn> turns = RandomTurns(40);
+    CubieCube cube;
+    for (size_t t = 0; t < turns.size(); t++) {
+      cube.Multiply(CubieCube::Turn(turns[t]));
+    }
+    Cube3 expected(TurnedState(turns));
+    Check(cube.ToFacelets() == expected, "cubie turns match the cube state");
+    Check(cube.IsSolvable(), "turned cubie cube is solvable");
+
+    CubieCube read;
+    Check(CubieCube::FromFacelets(expected, read) &&
+          read.ToFacelets() == expected, "facelets convert to cubies");
+
+    CubieCube solved = cube;
+    solved.Multiply(cube.Inverse());
+    Check(solved.ToFacelets().IsSolved(), "cubie inverse solves");
+  }
+}
+
+/**
+ * Check that notation reads face turns as the turns themselves.
+ */
+static void CheckNotation() {
+  const char* faces = "URFDLB";
+  const char* amounts[] = { "", "2", "'" };
+  for (int i = 0; i < 20; i++) {
+    std::vector<FaceTurn> turns = RandomTurns(50);
+    std::string text;
+    for (size_t t = 0; t < turns.size(); t++) {
+      text += std::string(1, faces[turns[t] / 3]) + amounts[turns[t] % 3] +
+              " ";
+    }
+    std::vector<Move> moves;
+    std::string error;
+    Check(Notation(3).Parse(text, moves, error), "notation parses");
+    CubeState state(3);
+    state.Apply(&moves[0], moves.size());
+    Check(state == TurnedState(turns), "notation matches face turns");
+  }
+
+  // The sexy move has order six on every size of cube.
+  for (int size = 2; size <= 6; size++) {
+    std::vector<Move> moves;
+    std::string error;
+    Notation(size).Parse("R U R' U' R U R' U' R U R' U' "
+                         "R U R' U' R U R' U' R U R' U'", moves, error);
+    CubeState state(size);
+    state.Apply(&moves[0], moves.size());
+    Check(state.IsSolved(), "size " + std::to_string(size) +
+                            ": (R U R' U')6 solves");
+  }
+}
+
+/**
+ * Check that a solution solves a scramble.
+ *
+ * @param turns The scramble.
+ * @param solution The solution.
+ * @return True if solved.
+ */
+static bool Solves(const std::vector<FaceTurn>& turns,
+                   const std::vector<FaceTurn>& solution) {
+  CubeState state = TurnedState(turns);
+  for (size_t i = 0; i < solution.size(); i++) {
+    state.Apply(FaceTurnMove(solution[i], 3));
+  }
+  return state.IsSolved();
+}
+
+/**
+ * Check that both solvers solve random cubes, the optimal solver in no more
+ * moves than the two-phase solver. The optimal solver is skipped unless its
+ * pattern databases have been built, which takes minutes.
+ */
+static void CheckSolvers() {
+  const TwoPhaseSolver& twoPhase = TwoPhaseSolver::Get();
+  for (int i = 0; i < 20; i++) {
+    std::vector<FaceTurn> turns = RandomTurns(30);
+    std::vector<FaceTurn> solution;
+    Check(twoPhase.Solve(TurnedState(turns), solution, 20, 0, 1 << 24) &&
+          Solves(turns, solution), "two-phase solution solves");
+  }
+
+  OptimalSolver optimal(7, 0, true);
+  if (!optimal.Load("./data/table", false)) {
+    std::cout << "Skipping the optimal solver: its pattern databases are "
+              << "not built (run \"solve --optimal\" once)" << std::endl;
+    return;
+  }
+  for (int i = 0; i < 10; i++) {
+    std::vector<FaceTurn> turns = RandomTurns(9);
+    std::vector<FaceTurn> solution, twoPhaseSolution;
+    Check(optimal.Solve(TurnedState(turns), solution) &&
+          Solves(turns, solution), "optimal solution solves");
+    twoPhase.Solve(TurnedState(turns), twoPhaseSolution, 20, 0, 1 << 24);
+    Check(solution.size() <= turns.size() &&
+          solution.size() <= twoPhaseSolution.size(),
+          "optimal solution is no longer than any other");
+  }
+}
+
+int main() {
+  srand(1);
+  CheckStateAndPermutation();
+  CheckKernels();
+  CheckCubieCube();
+  CheckNotation();
+  CheckSolvers();
+  std::cout << numChecks - numFailed << " of " << numChecks
+            << " checks passed" << std::endl;
+  return numFailed == 0 ? 0 : 1;
+}